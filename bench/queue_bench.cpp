@@ -0,0 +1,155 @@
+// queue_bench.cpp
+// Compares the search kernels' priority queues on random origin/destination
+// pairs, in input and Hilbert node order and on the compact graph.
+// Usage: queue_bench [graph.geojson | graph.snapshot] [queries]
+#include "graph.hpp"
+#include "algorithms.hpp"
+#include "compact_graph.hpp"
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <vector>
+
+struct QueueCase
+{
+    const char *name;
+    QueueKind kind;
+};
+
+// With `compact`, every query (preparation and unpacking included) runs on
+// the compact graph instead
+template <typename Kernel>
+static void runEngine(const char *engine, const Graph &g, const std::vector<std::pair<int, int>> &pairs,
+                      const std::vector<double> &reference, const CompactGraph *compact = nullptr)
+{
+    static const QueueCase cases[] = {
+        {"binary (lazy)", QueueKind::BinaryHeap},
+        {"4-ary indexed", QueueKind::QuaternaryHeap},
+        {"radix", QueueKind::RadixHeap},
+    };
+
+    for (const QueueCase &c : cases)
+    {
+        Kernel kernel;
+        kernel.queue = c.kind;
+
+        size_t visited = 0;
+        int mismatches = 0;
+        auto t0 = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < pairs.size(); ++i)
+        {
+            PathResult r;
+            if (compact)
+            {
+                CompactQuery query = compact->prepare(g, pairs[i].first, pairs[i].second);
+                r = kernel(query.graph(), query.src(), query.dest());
+                query.unpack(g, r);
+            }
+            else
+            {
+                r = kernel(g, pairs[i].first, pairs[i].second);
+            }
+            visited += r.nodeVisited;
+            // Radix keys are quantized to 1/1000 of a cost unit (1 ms of
+            // travel time), so lengths may differ by up to that
+            if (std::fabs(r.length - reference[i]) > 1e-3)
+                ++mismatches;
+        }
+        double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+
+        std::cout << std::left << std::setw(10) << engine << std::setw(16) << c.name
+                  << std::right << std::fixed << std::setprecision(3)
+                  << std::setw(10) << ms / pairs.size() << " ms/query"
+                  << std::setw(12) << visited / pairs.size() << " settled"
+                  << std::setw(6) << mismatches << " mismatches\n";
+    }
+}
+
+// Mean |u - v| over all edges, a proxy for how far apart in memory a
+// search's consecutive reads land
+static double meanEdgeSpan(const Graph &g)
+{
+    double sum = 0.0;
+    for (int u = 0; u < g.numNodes(); ++u)
+        for (int e = g.edgeBegin(u); e < g.edgeEnd(u); ++e)
+            sum += std::abs(g.edgeTarget(e) - u);
+    return g.numEdges() > 0 ? sum / g.numEdges() : 0.0;
+}
+
+// Run every engine with the same queries, given as build-phase ids
+static void runSuite(const char *label, const Graph &g, const std::vector<std::pair<int, int>> &original)
+{
+    std::vector<std::pair<int, int>> pairs;
+    for (const auto &p : original)
+        pairs.push_back({g.nodeFromOriginal(p.first), g.nodeFromOriginal(p.second)});
+
+    std::vector<double> reference;
+    for (const auto &p : pairs)
+        reference.push_back(DijkstraKernel{}(g, p.first, p.second).length);
+
+    std::cout << "Node order: " << label << " (mean edge span " << std::fixed << std::setprecision(1)
+              << meanEdgeSpan(g) << " ids)\n";
+    runEngine<DijkstraKernel>("Dijkstra", g, pairs, reference);
+    runEngine<AstarKernel>("A*", g, pairs, reference);
+}
+
+// Same queries with degree-2 chains collapsed
+static void runCompact(const Graph &g, const std::vector<std::pair<int, int>> &original)
+{
+    CompactGraph compact;
+    compact.build(g);
+
+    std::vector<std::pair<int, int>> pairs;
+    std::vector<double> reference;
+    for (const auto &p : original)
+    {
+        pairs.push_back({g.nodeFromOriginal(p.first), g.nodeFromOriginal(p.second)});
+        reference.push_back(DijkstraKernel{}(g, pairs.back().first, pairs.back().second).length);
+    }
+
+    std::cout << "Compact graph (chains collapsed, Hilbert order)\n";
+    runEngine<DijkstraKernel>("Dijkstra", g, pairs, reference, &compact);
+    runEngine<AstarKernel>("A*", g, pairs, reference, &compact);
+}
+
+int main(int argc, char **argv)
+{
+    const char *graphFile = argc > 1 ? argv[1] : "./data/dehradun.geojson";
+    const int queries = argc > 2 ? std::atoi(argv[2]) : 200;
+
+    try
+    {
+        Graph g;
+        g.load(graphFile);
+        if (g.numNodes() == 0)
+            throw std::runtime_error("Graph is empty");
+
+        std::mt19937 rng(42);
+        std::uniform_int_distribution<int> pick(0, g.numNodes() - 1);
+        std::vector<std::pair<int, int>> pairs(queries);
+        for (auto &p : pairs)
+            p = {pick(rng), pick(rng)};
+
+        std::cout << queries << " random queries on " << g.numNodes() << " nodes\n";
+
+        // A snapshot keeps the order it was saved with; GeoJSON is also
+        // timed in input order to show what the renumbering buys
+        if (!Graph::isSnapshotFile(graphFile))
+        {
+            Graph input;
+            input.load(graphFile, NodeOrder::Input);
+            runSuite("input", input, pairs);
+        }
+        runSuite("hilbert", g, pairs);
+        runCompact(g, pairs);
+    }
+    catch (const std::exception &e)
+    {
+        std::cerr << "Error: " << e.what() << "\n";
+        return 1;
+    }
+    return 0;
+}
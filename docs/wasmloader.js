@@ -56,17 +56,23 @@ export async function initWasm() {
     },
 
     /**
-     * Find shortest route using A* or Dijkstra
+     * Find shortest routes using A*, Dijkstra or their bidirectional variants
      * @param {number} lat1
      * @param {number} lon1
      * @param {number} lat2
      * @param {number} lon2
-     * @param {number} useAstar - 1 = A*, 0 = Dijkstra
+     * @param {number} useAstar - 0 = Dijkstra, 1 = A*, 2 = bidirectional Dijkstra, 3 = bidirectional A*,
+     *   4 = contraction hierarchy (single route, hierarchy built on first call),
+     *   5 = ALT A* (landmarks built on first call)
+     * @param {number} [k=4] - Number of routes to return
+     * @param {number} [maxDetourRatio=0] - Drop routes longer than this multiple of the shortest (0 = no limit)
+     * @param {number} [timeBudgetMS=0] - Stop searching for more routes after this many ms (0 = no limit)
+     * @param {number} [profile=0] - 0 = car, 1 = distance, 2 = two-wheeler, 3 = walking
      * @returns {object|null} Parsed route or null on error
      */
-    findkShortestRoute: (lat1, lon1, lat2, lon2, useastar) => {
+    findkShortestRoute: (lat1, lon1, lat2, lon2, useastar, k = 4, maxDetourRatio = 0, timeBudgetMS = 0, profile = 0) => {
       return handleJsonResult(() =>
-        wasmInstance._findKShortestRoutes(lat1, lon1, lat2, lon2, useastar)
+        wasmInstance._findKShortestRoutes(lat1, lon1, lat2, lon2, useastar, k, maxDetourRatio, timeBudgetMS, profile)
       );
     },
 
@@ -78,6 +84,82 @@ export async function initWasm() {
       return handleJsonResult(() => wasmInstance._criticalpoints());
     },
 
+    /**
+     * Get articulation points, bridges, biconnected components and the
+     * block-cut tree ([component, articulation point index] pairs).
+     * @returns {object|null} Parsed biconnectivity data or null
+     */
+    getBiconnectedComponents: () => {
+      return handleJsonResult(() => wasmInstance._biconnectedcomponents());
+    },
+
+    /**
+     * Close every road segment between the nodes nearest to two points.
+     * @returns {object|null} Nodes that became or stopped being critical and
+     *   bridges gained or lost, or null
+     */
+    closeRoad: (lat1, lon1, lat2, lon2) => {
+      return handleJsonResult(() => wasmInstance._closeroad(lat1, lon1, lat2, lon2));
+    },
+
+    /**
+     * Reopen a segment closed with closeRoad; same result shape.
+     * @returns {object|null} Parsed change set or null
+     */
+    reopenRoad: (lat1, lon1, lat2, lon2) => {
+      return handleJsonResult(() => wasmInstance._reopenroad(lat1, lon1, lat2, lon2));
+    },
+
+    /**
+     * Travel costs between every source and target, snapped to the nearest nodes.
+     * @param {Array<[number, number]>} sources - [lat, lon] pairs
+     * @param {Array<[number, number]>} targets - [lat, lon] pairs
+     * @param {number} [profile=0] - As for findkShortestRoute
+     * @returns {object|null} Snapped points and costs[source][target]
+     *   (null where unreachable), or null on error
+     */
+    distanceMatrix: (sources, targets, profile = 0) => {
+      const ptr = allocateUTF8(JSON.stringify({ sources, targets, profile }));
+      try {
+        return handleJsonResult(() => wasmInstance._distancematrix(ptr));
+      } finally {
+        free(ptr);
+      }
+    },
+
+    /**
+     * Areas reachable from a point, as a GeoJSON FeatureCollection with one
+     * MultiPolygon feature per band.
+     * @param {number} lat
+     * @param {number} lon
+     * @param {number} maxCost - Budget in the profile's units (seconds, or metres for distance)
+     * @param {number} [bands=1] - Features at maxCost / bands, 2 * maxCost / bands, ... maxCost
+     * @param {number} [cellMetres=100] - Grid resolution of the outlines
+     * @param {number} [profile=0] - As for findkShortestRoute
+     * @returns {object|null} Parsed GeoJSON or null on error
+     */
+    isochrone: (lat, lon, maxCost, bands = 1, cellMetres = 100, profile = 0) => {
+      return handleJsonResult(() => wasmInstance._isochrone(lat, lon, maxCost, bands, cellMetres, profile));
+    },
+
+    /**
+     * Route many queries in one call, e.g. to replay a request log.
+     * @param {Array<object>} queries - { from: [lat, lon], to: [lat, lon] } plus
+     *   optional algorithm, k, maxDetourRatio, timeBudgetMS and profile as for
+     *   findkShortestRoute
+     * @param {number} [threads=0] - Worker threads to spread queries over (0 = all)
+     * @returns {object|null} results[i] answering queries[i] (null if invalid),
+     *   or null on error
+     */
+    batchRoutes: (queries, threads = 0) => {
+      const ptr = allocateUTF8(JSON.stringify({ queries, threads }));
+      try {
+        return handleJsonResult(() => wasmInstance._batchroutes(ptr));
+      } finally {
+        free(ptr);
+      }
+    },
+
     /**
      * Expose internal WASM utils if needed
      */
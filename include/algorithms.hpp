@@ -2,22 +2,18 @@
 
 #include<vector>
 #include<tuple>
-#include <unordered_set>
 #include <functional>
 #include <sys/resource.h>
 #include <unistd.h>
 #include <fstream>
 #include <sstream>
 #include"graph.hpp"
+#include"block_set.hpp"
+#include"priority_queues.hpp"
 
 
 static size_t getCurrentRSSKB();
 static size_t getMemoryUsageKB();
-struct PairIntHash {
-    size_t operator()(const std::pair<int, int>& p) const {
-        return std::hash<int>()(p.first) ^ (std::hash<int>()(p.second) << 1);
-    }
-};
 
 struct PathResult
 {
@@ -34,18 +30,75 @@ struct KPathsResult {
     size_t memoryUsage = 0;
 };
 
-using ShortestPathFunc = std::function<PathResult(const Graph&, int, int,
-    const std::unordered_set<std::pair<int, int>, PairIntHash>&,
-    const std::unordered_set<int>&)>;
+// Shortest path avoiding the nodes and edges in the BlockSet, which must be
+// sized for the graph
+using ShortestPathFunc = std::function<PathResult(const Graph&, int, int, const BlockSet&)>;
 
 PathResult astarWithBlock(const Graph& g, int src, int dest,
-    const std::unordered_set<std::pair<int, int>, PairIntHash>& blockedEdges,
-    const std::unordered_set<int>& blockedNodes);
+    const BlockSet& blocked);
 
 PathResult dijkstraWithBlock(const Graph& g, int src, int dest,
-    const std::unordered_set<std::pair<int, int>, PairIntHash>& blockedEdges,
-    const std::unordered_set<int>& blockedNodes);
+    const BlockSet& blocked);
+
+class Landmarks;
+
+// A* bounded by landmark distances (ALT) as well as the straight line; wrap in a
+// lambda capturing the landmarks to use it as a ShortestPathFunc
+PathResult altAstarWithBlock(const Graph& g, const Landmarks& landmarks, int src, int dest,
+    const BlockSet& blocked);
+
+// Bidirectional variants with the same blocking contract, usable as a ShortestPathFunc
+PathResult bidirectionalDijkstraWithBlock(const Graph& g, int src, int dest,
+    const BlockSet& blocked);
+
+PathResult bidirectionalAstarWithBlock(const Graph& g, int src, int dest,
+    const BlockSet& blocked);
+
+// Search engines as kernel types for the templated yenKShortestPaths in
+// yen.hpp. The three-argument call is the unblocked instantiation used for
+// the first route; spur searches use the BlockSet overload. Dijkstra and A*
+// can run on any queue from priority_queues.hpp.
+struct DijkstraKernel {
+    QueueKind queue = QueueKind::BinaryHeap;
+    PathResult operator()(const Graph& g, int src, int dest) const;
+    PathResult operator()(const Graph& g, int src, int dest, const BlockSet& blocked) const;
+};
+
+struct AstarKernel {
+    QueueKind queue = QueueKind::BinaryHeap;
+    PathResult operator()(const Graph& g, int src, int dest) const;
+    PathResult operator()(const Graph& g, int src, int dest, const BlockSet& blocked) const;
+};
+
+struct AltKernel {
+    const Landmarks* landmarks;
+    PathResult operator()(const Graph& g, int src, int dest) const;
+    PathResult operator()(const Graph& g, int src, int dest, const BlockSet& blocked) const;
+};
+
+struct BidirectionalDijkstraKernel {
+    PathResult operator()(const Graph& g, int src, int dest) const;
+    PathResult operator()(const Graph& g, int src, int dest, const BlockSet& blocked) const;
+};
+
+struct BidirectionalAstarKernel {
+    PathResult operator()(const Graph& g, int src, int dest) const;
+    PathResult operator()(const Graph& g, int src, int dest, const BlockSet& blocked) const;
+};
+
+// Limits for yenKShortestPaths; the defaults return up to four routes
+struct YenOptions {
+    int k = 4;                    // routes to return, including the shortest
+    double maxDetourRatio = 0.0;  // > 0: skip routes longer than ratio x shortest
+    double timeBudgetMS = 0.0;    // > 0: stop looking for more routes after this
+    int threads = 1;              // spur searches in parallel; 0 = all cores
+};
 
-KPathsResult yenKShortestPaths(const Graph& g, int src, int dest, ShortestPathFunc shortestPathWithBlock);
+// Runtime-dispatched Yen over a ShortestPathFunc; include yen.hpp to
+// specialize on a kernel type instead
+KPathsResult yenKShortestPaths(const Graph& g, int src, int dest, ShortestPathFunc shortestPathWithBlock,
+    const YenOptions& options = {});
 
-PathResult findCriticalPoints(const Graph&g);
\ No newline at end of file
+// Articulation points in ascending order; threads as in findCriticalElements
+// (connectivity.hpp)
+PathResult findCriticalPoints(const Graph&g, int threads = 1);
\ No newline at end of file
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <stdexcept>
+#include <vector>
+#include "graph.hpp"
+
+// Nodes and edges a search must avoid, keyed by node id and by edge id in
+// the graph's adjacency layout. An entry is blocked when its stamp equals
+// the current epoch, so a check is one array load and clear() is O(1).
+class BlockSet
+{
+public:
+    BlockSet() = default;
+    explicit BlockSet(const Graph &g) { reset(g); }
+
+    // Size for g and unblock everything; keeps capacity across calls
+    void reset(const Graph &g)
+    {
+        if (nodeStamp.size() != (size_t)g.numNodes() || edgeStamp.size() != (size_t)g.numEdges())
+        {
+            nodeStamp.assign(g.numNodes(), 0);
+            edgeStamp.assign(g.numEdges(), 0);
+            epoch = 0;
+        }
+        clear();
+    }
+
+    void clear()
+    {
+        if (++epoch == 0)
+        {
+            // Stamps wrapped around: clear them once and start over
+            std::fill(nodeStamp.begin(), nodeStamp.end(), 0);
+            std::fill(edgeStamp.begin(), edgeStamp.end(), 0);
+            epoch = 1;
+        }
+    }
+
+    void blockNode(int v) { nodeStamp[v] = epoch; }
+    void blockEdge(int e) { edgeStamp[e] = epoch; }
+
+    // Block every edge u -> v, parallel edges included
+    void blockEdgesBetween(const Graph &g, int u, int v)
+    {
+        for (int e = g.edgeBegin(u), end = g.edgeEnd(u); e < end; ++e)
+            if (g.edgeTarget(e) == v)
+                edgeStamp[e] = epoch;
+    }
+
+    bool nodeBlocked(int v) const { return nodeStamp[v] == epoch; }
+    bool edgeBlocked(int e) const { return edgeStamp[e] == epoch; }
+
+    // Searches call this once up front so the per-edge checks need no bounds test
+    void requireSizedFor(const Graph &g) const
+    {
+        if (nodeStamp.size() != (size_t)g.numNodes() || edgeStamp.size() != (size_t)g.numEdges())
+            throw std::invalid_argument("BlockSet is not sized for this graph; call reset(g)");
+    }
+
+private:
+    std::vector<uint32_t> nodeStamp;
+    std::vector<uint32_t> edgeStamp;
+    uint32_t epoch = 1;
+};
@@ -0,0 +1,73 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "graph.hpp"
+#include "algorithms.hpp"
+
+// Contraction hierarchy over a Graph's edges. build() ranks the nodes and
+// contracts them one by one, adding a shortcut u -> w whenever the path
+// u -> v -> w through the contracted node v is the only shortest one. A
+// query then runs two Dijkstra searches that only ever move to higher
+// ranked nodes. Each shortcut remembers the two edges it replaces, so
+// results unpack to the original node ids.
+class ContractionHierarchy {
+public:
+    // Order and contract every node of g, weighted by g's edge weights
+    void build(const Graph& g);
+
+    // Shortest path between original node ids; empty path if unreachable
+    PathResult query(int src, int dest) const;
+
+    // Binary serialization of the finished hierarchy
+    void save(const std::string& filename) const;
+    void load(const std::string& filename);
+
+    bool empty() const { return rank.empty(); }
+
+    // True when built from a graph with g's profile, node and edge counts,
+    // edges, weights and node numbering
+    bool matches(const Graph& g) const;
+
+    // Profile of the graph this was built from
+    Profile profile() const { return graphProfile; }
+
+    int numNodes() const { return (int)rank.size(); }
+    size_t numShortcuts() const { return edges.size() - graphEdges; }
+
+private:
+    struct Edge {
+        int from;
+        int to;
+        Distance weight;  // weight units, see graph.hpp
+        int childA;  // u -> v half of a shortcut, -1 for an original edge
+        int childB;  // v -> w half of a shortcut
+    };
+
+    // Append the nodes of edge e after its tail, expanding shortcuts
+    void unpackEdge(int e, std::vector<int>& path) const;
+
+    // Edge id on the search graph between adjacent nodes of a query path
+    int upEdge(int from, int to) const;
+    int downEdge(int from, int to) const;
+
+    std::vector<int> rank;
+    std::vector<Edge> edges;
+
+    // Upward search graphs as CSR over edge ids: upEdges[u] leave u towards
+    // higher ranks, downEdges[v] enter v from higher ranks
+    std::vector<int> upOffsets;
+    std::vector<int> upEdges;
+    std::vector<int> downOffsets;
+    std::vector<int> downEdges;
+
+    // Edges copied from the graph; everything after them is a shortcut
+    size_t graphEdges = 0;
+
+    // Shape of the source graph, checked by matches()
+    int graphNodes = 0;
+    int graphEdgeCount = 0;
+    uint64_t graphFingerprint = 0;
+    Profile graphProfile = Profile::Car;
+};
@@ -0,0 +1,145 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include "graph.hpp"
+#include "algorithms.hpp"
+
+class CompactGraph;
+
+// The graph one route query searches: the compact graph itself when both
+// endpoints are junctions, otherwise an edited copy in which the chains
+// holding them are split at them. Node ids below the compact graph's node
+// count are compact nodes; the split points come after them.
+class CompactQuery {
+public:
+    const Graph& graph() const { return split ? overlay : *base; }
+    int src() const { return srcNode; }
+    int dest() const { return destNode; }
+
+    // Rewrite a route found on graph() in full-graph node ids, with its
+    // length measured on the full graph
+    void unpack(const Graph& full, PathResult& route) const;
+
+private:
+    friend class CompactGraph;
+
+    // Chain slice [begin, end) between query nodes from and to, in from -> to order
+    struct Piece {
+        int from;
+        int to;
+        int begin;
+        int end;
+    };
+
+    int fullNode(int x) const;
+
+    const CompactGraph* owner = nullptr;
+    const Graph* base = nullptr;
+    Graph overlay;
+    bool split = false;
+    std::vector<int> extraFull;  // full-graph node of each split point
+    std::vector<Piece> pieces;
+    int srcNode = -1;
+    int destNode = -1;
+};
+
+// Routing graph with every chain of degree-2 nodes collapsed into one
+// segment. GeoJSON gives every LineString vertex its own node, so most
+// nodes only continue a road; the compact graph keeps the junctions (any
+// other degree) and joins them by segments carrying the chain's summed
+// weight in each direction (impassable if any hop is), remembering the chain's nodes so routes unpack to the same
+// coordinates. Where two segments would join the same pair of junctions, or
+// a chain returns to where it started, one of its nodes stays as a junction
+// so every route is still a distinct node sequence.
+//
+// Chains depend on topology alone, so compact graphs of different profiles
+// share it; each keeps only its own segment and hop weights.
+class CompactGraph {
+public:
+    // Find the chains of g and build the compact graph over its junctions
+    void build(const Graph& g);
+
+    // Compact graph of `view`, a profile view of the graph this one was
+    // built from, sharing this one's chains and junctions
+    CompactGraph withProfile(const Graph& view) const;
+
+    bool empty() const { return !topo; }
+
+    // True when built from a graph with g's node and edge counts
+    bool matches(const Graph& g) const;
+
+    const Graph& graph() const { return compact; }
+
+    // Compact node of full-graph node u, -1 inside a chain
+    int compactNode(int u) const { return topo->toCompact[u]; }
+    int fullNode(int c) const { return topo->toFull[c]; }
+
+    // Graph and endpoints to route full-graph nodes src -> dest on; full is
+    // the graph this was built from
+    CompactQuery prepare(const Graph& full, int src, int dest) const;
+
+private:
+    friend class CompactQuery;
+
+    // Maximal run of chain nodes between junctions from and to. Hop h in
+    // [begin, end) enters interior[h]; hop end enters to.
+    struct Chain {
+        int from;
+        int to;
+        int begin;  // slice of interior
+        int end;
+        int lastEdge;      // full-graph edge of hop end
+        int lastBackEdge;  // the same hop walked towards from
+    };
+
+    // Everything derived from the full graph's topology, shared by the
+    // compact graphs of all its profiles
+    struct Topology {
+        Graph junctions;  // the compact graph, weighted as the graph build() got
+        std::vector<int> toCompact;
+        std::vector<int> toFull;
+
+        std::vector<Chain> chains;
+        std::vector<int> interior;       // chain nodes (full ids), chain by chain in from -> to order
+        std::vector<int> hopEdge;        // full-graph edge entering each interior entry
+        std::vector<int> hopBackEdge;    // the same hop walked towards from
+        std::vector<int> interiorChain;  // chain of each interior entry
+        std::vector<int> slot;           // index into interior per full node, -1 for junctions
+        std::unordered_map<uint64_t, int> chainByEnds;
+
+        // Per compact edge: the chain it collapses, or -1 and the full-graph
+        // edge it copies
+        std::vector<int> edgeChain;
+        std::vector<int> edgeFull;
+
+        int graphNodes = 0;
+        int graphEdgeCount = 0;
+    };
+
+    // Fill the per-hop weights from g's edges
+    void readHops(const Graph& g);
+
+    // Weight of hops [first, last] of chain c, walked from -> to when
+    // forward; INF_WEIGHT if any of them is impassable
+    EdgeWeight hopSum(int c, int first, int last, bool forward) const;
+
+    static uint64_t pairKey(int a, int b)
+    {
+        if (a > b)
+            std::swap(a, b);
+        return (uint64_t)(uint32_t)a << 32 | (uint32_t)b;
+    }
+
+    std::shared_ptr<const Topology> topo;
+
+    // This profile's weights: a view of topo->junctions, and per hop
+    Graph compact;
+    std::vector<EdgeWeight> hopForward;    // hop entering each interior entry
+    std::vector<EdgeWeight> hopBackward;   // the same hop walked towards from
+    std::vector<EdgeWeight> lastForward;   // hop end of each chain
+    std::vector<EdgeWeight> lastBackward;
+};
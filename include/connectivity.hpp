@@ -0,0 +1,127 @@
+#pragma once
+
+#include <cstdint>
+#include <utility>
+#include <vector>
+#include "graph.hpp"
+#include "algorithms.hpp"
+
+// Articulation points, bridges and biconnected components of the road
+// network, all from one iterative DFS. Graph edges are the two directed
+// halves of each road segment; both halves of a segment share its
+// component, and parallel segments between the same nodes are a cycle, so
+// neither of them is a bridge.
+struct BiconnectivityResult {
+    std::vector<int> articulationPoints;  // node ids, ascending
+    std::vector<int> bridges;             // per bridge segment, the edge id leaving its lower node; ascending
+    std::vector<int> edgeComponent;       // component per edge id, -1 for self-loops
+    int numComponents = 0;
+
+    // Block-cut tree: an edge joins block (component) c and cut node a
+    // whenever a lies in c. Pairs are (c, a), sorted.
+    std::vector<std::pair<int, int>> blockCutEdges;
+
+    double timeMS = 0.0;
+    size_t memoryUsage = 0;
+};
+
+BiconnectivityResult findBiconnectedComponents(const Graph& g);
+
+// Articulation points and bridges without the component labelling
+struct CriticalElements {
+    std::vector<int> articulationPoints;  // as in BiconnectivityResult
+    std::vector<int> bridges;
+    int connectedComponents = 0;          // including isolated nodes
+    double timeMS = 0.0;
+    size_t memoryUsage = 0;
+};
+
+// threads == 1 runs one DFS per connected component. Otherwise a concurrent
+// union-find splits the graph into components first; small components get
+// one DFS each on the shared ThreadPool and large ones run Tarjan-Vishkin,
+// whose steps are all parallel loops. The result is the same for every
+// thread count. 0 = every thread the pool has.
+CriticalElements findCriticalElements(const Graph& g, int threads = 0);
+
+// What one closure or reopening changed
+struct ClosureUpdate {
+    std::vector<int> newlyCritical;    // nodes that became articulation points
+    std::vector<int> noLongerCritical;
+    std::vector<int> newBridges;       // edge ids as in BiconnectivityResult
+    std::vector<int> removedBridges;
+    size_t nodesVisited = 0;           // work done, for comparison with a full pass
+};
+
+// Articulation points and bridges kept up to date while road segments are
+// closed and reopened, starting from one full findBiconnectedComponents.
+// Every open segment carries a block id; blocks are the sets of a
+// union-find, so merging them is cheap:
+//
+//   reopen  The blocks along any path between the segment's ends merge
+//           into one. Only nodes on that path can stop being critical.
+//   close   A bridge's block simply disappears. Otherwise a detour path P
+//           through the rest of the block is found, and the block's other
+//           nodes are searched outwards from P in clusters that record the
+//           span of P they touch. The search stops as soon as every inner
+//           node of P is spanned (nothing changed, the usual case on a road
+//           grid) or shown to separate two exhausted sides; those nodes
+//           become critical and only the exhausted pieces are relabelled.
+//
+// Both walk only around the affected segment on typical road networks. The
+// worst case, a new cut node with two large sides, still explores the
+// whole block.
+class DynamicCriticalPoints {
+public:
+    explicit DynamicCriticalPoints(const Graph& g);
+
+    // Close or reopen the segment that edge e is one half of; a no-op when
+    // it already is closed or open
+    ClosureUpdate closeEdge(int e);
+    ClosureUpdate reopenEdge(int e);
+
+    bool isClosed(int e) const { return closed[e] != 0; }
+    bool isCritical(int u) const { return isArt[u] != 0; }
+    bool isBridge(int e) const;
+
+    // Current state in the order of findCriticalElements
+    std::vector<int> criticalPoints() const;
+    std::vector<int> bridges() const;
+
+private:
+    int blockOf(int e) const;
+    int newBlock(int segments);
+    int tail(int e) const { return g.edgeTarget(twin[e]); }
+    int lowerHalf(int e) const { return tail(e) < g.edgeTarget(e) ? e : twin[e]; }
+    bool usable(int e, int block) const;
+
+    // Re-derive u's articulation flag from its open segments' blocks
+    void refresh(int u, ClosureUpdate& update);
+
+    // Some simple path from u to v over open edges of `block` (-1 = any),
+    // as edge ids in order; false when none exists
+    bool connect(int u, int v, int block, std::vector<int>& path, size_t& visited);
+
+    // Closing a non-bridge segment of block b between u and v
+    void splitBlock(int b, int u, int v, ClosureUpdate& update);
+
+    void nextEpoch();
+
+    const Graph& g;
+    std::vector<int> twin;       // the other half of each segment
+    std::vector<char> closed;
+    std::vector<int> edgeBlock;  // union-find element, -1 for self-loops
+    std::vector<char> isArt;
+
+    mutable std::vector<int> blockParent;
+    std::vector<int> blockSegments;  // open segments, valid at set roots
+
+    // Scratch for one update; entries are valid while stamp[x] == epoch
+    std::vector<uint32_t> stamp;
+    uint32_t epoch = 0;
+    std::vector<int> link;       // search tree edge or cluster parent
+    std::vector<char> side;      // which end connect() reached a node from
+    std::vector<int> pathIndex;  // position on P, -1 for other nodes
+    std::vector<int> clusterMin;
+    std::vector<int> clusterMax;
+    std::vector<int> clusterPending;
+};
@@ -4,7 +4,11 @@
 #include <string>
 #include <unordered_map>
 #include <utility>
+#include <memory>
 #include <cmath>
+#include <cstdint>
+#include <limits>
+#include "spatial_index.hpp"
 
 // Hash function for pair<double, double>
 struct PairHash {
@@ -15,47 +19,398 @@ struct PairHash {
     }
 };
 
-// Neighbor info: node index + edge weight
-struct Neighbor {
-    int index;
-    double weight;
-};
-
-// Node stores coordinates, critical flag, and neighbors
+// Node stores coordinates; laid out exactly as in a graph snapshot
 struct Node {
     double lat;
     double lon;
-    bool isCritical = false;
-    std::vector<Neighbor> neighbors;
+};
+
+// Node position on the unit sphere. The chord between two of them is at most
+// the great-circle arc, so it bounds road distances from below.
+struct UnitVector {
+    double x;
+    double y;
+    double z;
+};
+
+// Edge weights are costs: car travel time in seconds for roads loaded from
+// GeoJSON, whatever the caller passed to addEdge otherwise; see Profile for
+// the other costings. They are double
+// by default. Building with OSM_FIXED_POINT_WEIGHTS stores them as 32-bit
+// integer hundredths and sums path costs in 64-bit integers instead;
+// PathResult lengths are still reported in whole cost units. Searches work
+// in weight units throughout.
+#ifdef OSM_FIXED_POINT_WEIGHTS
+using EdgeWeight = uint32_t;
+using Distance = int64_t;
+constexpr double WEIGHT_SCALE = 100.0;  // weight units per cost unit
+constexpr Distance INF_DISTANCE = std::numeric_limits<int64_t>::max() / 4;  // INF + INF must not overflow
+constexpr EdgeWeight INF_WEIGHT = std::numeric_limits<uint32_t>::max();
+#else
+using EdgeWeight = double;
+using Distance = double;
+constexpr double WEIGHT_SCALE = 1.0;
+constexpr Distance INF_DISTANCE = std::numeric_limits<double>::infinity();
+constexpr EdgeWeight INF_WEIGHT = std::numeric_limits<double>::infinity();
+#endif
+
+// Edges weighted INF_WEIGHT exist in the topology but may not be used, such
+// as the half of a one-way street against traffic. Searches skip them.
+inline bool isPassable(EdgeWeight w) { return w != INF_WEIGHT; }
+
+// OSM highway classes; *_link roads share their road's class
+enum class RoadClass : uint8_t {
+    Unknown,
+    Motorway,
+    Trunk,
+    Primary,
+    Secondary,
+    Tertiary,
+    Unclassified,
+    Residential,
+    LivingStreet,
+    Service,
+    Track,
+    Pedestrian,
+    Footway,
+    Cycleway,
+    Path,
+    Steps,
+};
+
+// Direction of an edge relative to its way's one-way restriction
+enum class OneWay : uint8_t {
+    No,       // two-way road
+    Along,    // one-way, this edge follows it
+    Against,  // one-way, this edge runs against traffic
+};
+
+// Per-edge OSM attributes, stored packed in 16 bits: road class in bits 0-4,
+// one-way in bits 5-6, tagged maxspeed in km/h in bits 7-14 (0 = untagged)
+struct EdgeAttributes {
+    RoadClass roadClass = RoadClass::Unknown;
+    OneWay oneway = OneWay::No;
+    uint8_t maxSpeedKmh = 0;
+
+    uint16_t pack() const {
+        return (uint16_t)((unsigned)roadClass | (unsigned)oneway << 5 | (unsigned)maxSpeedKmh << 7);
+    }
+    static EdgeAttributes unpack(uint16_t bits) {
+        return {(RoadClass)(bits & 31), (OneWay)(bits >> 5 & 3), (uint8_t)(bits >> 7)};
+    }
+
+    // The same road seen from the other end
+    EdgeAttributes reversed() const {
+        EdgeAttributes r = *this;
+        if (oneway != OneWay::No)
+            r.oneway = oneway == OneWay::Along ? OneWay::Against : OneWay::Along;
+        return r;
+    }
+};
+
+// What a route is costed for. A graph's own weights are Car; the others are
+// derived per edge from its length and attributes, see Graph::withProfile().
+enum class Profile : uint8_t {
+    Car,       // motor vehicle travel time, off footways and obeying one-ways
+    Distance,  // metres on any road, in either direction
+    Bike,      // two-wheeler travel time: the car's roads at up to 50 km/h
+    Foot,      // walking time on anything but motorways, in either direction
+};
+constexpr int PROFILE_COUNT = 4;
+
+// Node numbering chosen by Graph::finalize()
+enum class NodeOrder {
+    Input,    // order of first appearance while building
+    Hilbert,  // along a Hilbert curve over lat/lon, so nearby nodes get nearby ids
+};
+
+// Read-only array that either owns its elements or views memory owned
+// elsewhere (a mapped snapshot). Indexing never branches on which.
+template <typename T>
+class Column {
+public:
+    Column() = default;
+    Column(const Column& other) { *this = other; }
+    Column(Column&& other) noexcept { *this = std::move(other); }
+
+    Column& operator=(const Column& other) {
+        if (this == &other)
+            return *this;
+        owned = other.owned;
+        ptr = other.isOwned() ? owned.data() : other.ptr;
+        count = other.count;
+        return *this;
+    }
+
+    Column& operator=(Column&& other) noexcept {
+        bool wasOwned = other.isOwned();
+        owned = std::move(other.owned);
+        ptr = wasOwned ? owned.data() : other.ptr;
+        count = other.count;
+        other.ptr = nullptr;
+        other.count = 0;
+        return *this;
+    }
+
+    // Take ownership of a built array
+    void assign(std::vector<T>&& values) {
+        owned = std::move(values);
+        ptr = owned.data();
+        count = owned.size();
+    }
+
+    // Point at external storage that outlives this column
+    void view(const T* data, std::size_t size) {
+        std::vector<T>().swap(owned);
+        ptr = data;
+        count = size;
+    }
+
+    void clear() { assign({}); }
+
+    const T& operator[](std::size_t i) const { return ptr[i]; }
+    const T* data() const { return ptr; }
+    const T* begin() const { return ptr; }
+    const T* end() const { return ptr + count; }
+    std::size_t size() const { return count; }
+    bool empty() const { return count == 0; }
+
+private:
+    bool isOwned() const { return ptr == owned.data(); }
+
+    std::vector<T> owned;
+    const T* ptr = nullptr;
+    std::size_t count = 0;
 };
 
 class Graph {
 public:
     Graph();
 
+    // Load either a GeoJSON file or a snapshot, detected from the file header.
+    // A snapshot keeps the order it was saved with.
+    void load(const std::string& filename, NodeOrder order = NodeOrder::Hilbert);
+
     // Load graph from GeoJSON file (implementation in cpp)
-    void loadFromGeoJSON(const std::string& filename);
+    // Replaces any previously loaded graph and finalizes the adjacency
+    void loadFromGeoJSON(const std::string& filename, NodeOrder order = NodeOrder::Hilbert);
+
+    // Write the finalized graph as a versioned binary snapshot (snapshot.cpp)
+    void saveSnapshot(const std::string& filename) const;
+
+    // Map a snapshot read-only; queries read straight from the mapping
+    void openSnapshot(const std::string& filename);
 
-    // Get or assign index for coordinate (lat, lon)
+    // True when the file starts with the snapshot magic
+    static bool isSnapshotFile(const std::string& filename);
+
+    // Get or assign index for coordinate (lat, lon), build phase only
     int getNodeIndex(double lat, double lon);
 
-    // Find nearest node to given lat/lon
+    // Queue an undirected road segment between two node indices, build phase only
+    void addEdge(int u, int v, double weight);
+
+    // As addEdge, with the u -> v and v -> u weights already in weight units
+    void addSegment(int u, int v, EdgeWeight forward, EdgeWeight backward);
+
+    // Queue a road segment of `metres` drawn from u to v, weighted by car
+    // travel time at its maxspeed (or its class's typical speed when
+    // untagged). Halves cars may not use, such as one against a one-way, get
+    // INF_WEIGHT. wayId is the OSM way id, -1 when unknown.
+    void addRoad(int u, int v, double metres, const EdgeAttributes& attributes, int64_t wayId);
+
+    // Typical speed of a road class where maxspeed is not tagged
+    static double defaultSpeedKmh(RoadClass roadClass);
+
+    // Weight under `profile` of an edge of `metres` with attributes a, or
+    // INF_WEIGHT where the profile may not use it
+    static EdgeWeight profileWeight(Profile profile, double metres, const EdgeAttributes& a);
+
+    // Freeze queued segments into the compressed sparse row (CSR) adjacency,
+    // renumbering nodes by `order`. Indices returned by getNodeIndex() are
+    // build-phase ids afterwards; see originalId().
+    void finalize(NodeOrder order = NodeOrder::Hilbert);
+
+    // Segment for edited(), in weight units
+    struct Segment {
+        int u;
+        int v;
+        EdgeWeight forward;   // u -> v
+        EdgeWeight backward;  // v -> u
+    };
+
+    // Copy of this finalized graph with extraNodes appended (ids numNodes(),
+    // numNodes() + 1, ...), the edge halves in removedEdges dropped and
+    // addedSegments appended to their endpoints' edge lists. Nothing is
+    // renumbered and neither the spatial index nor edge attributes are
+    // carried over, so it is cheap enough to make per query;
+    // findNearestNode(), edgeAttributes() and wayId() are not available on
+    // the copy.
+    Graph edited(const std::vector<Node>& extraNodes, const std::vector<int>& removedEdges,
+                 const std::vector<Segment>& addedSegments) const;
+
+    // View of this finalized graph costed for `profile`. Nodes, edges,
+    // indexes and attributes are shared; only the weight array is new, and
+    // Profile::Car reuses this graph's own. The view points into this
+    // graph's storage, which must outlive it.
+    Graph withProfile(Profile profile) const;
+
+    // As withProfile(), with one weight per edge (in weight units) computed
+    // by the caller; empty weights share this graph's own
+    Graph withWeights(Profile profile, std::vector<EdgeWeight> weights) const;
+
+    // Costing of this graph's weights: Car unless it came from withProfile()
+    Profile profile() const { return costProfile; }
+
+    int numNodes() const { return (int)nodes.size(); }
+    int numEdges() const { return (int)edgeTargets.size(); }
+
+    // Outgoing edges of node u are the edge ids in [edgeBegin(u), edgeEnd(u))
+    int edgeBegin(int u) const { return edgeOffsets[u]; }
+    int edgeEnd(int u) const { return edgeOffsets[u + 1]; }
+    int edgeTarget(int e) const { return edgeTargets[e]; }
+    EdgeWeight edgeWeight(int e) const { return edgeWeights[e]; }
+
+    // Cold per-edge data, kept out of the arrays searches read
+    EdgeAttributes edgeAttributes(int e) const { return EdgeAttributes::unpack(edgeAttrs[e]); }
+    int64_t wayId(int e) const { return wayIds[edgeWays[e]]; }
+
+    // Incoming edges of node v are the reverse ids in [reverseBegin(v), reverseEnd(v));
+    // each names the tail node and the forward edge id it mirrors
+    int reverseBegin(int v) const { return reverseOffsets[v]; }
+    int reverseEnd(int v) const { return reverseOffsets[v + 1]; }
+    int reverseSource(int r) const { return reverseSources[r]; }
+    int reverseEdge(int r) const { return reverseEdges[r]; }
+
+    // First edge id from u to v, or -1 if they are not adjacent
+    int findEdge(int u, int v) const;
+
+    // Lightest passable edge from u to v, or -1 if there is none
+    int cheapestEdge(int u, int v) const;
+
+    // Find nearest node to given lat/lon through the spatial index
     int findNearestNode(double lat, double lon) const;
 
+    // Snap many (lat, lon) points at once, results in input order
+    std::vector<int> findNearestNodes(const std::vector<std::pair<double, double>>& points) const;
+
+    // As findNearestNode(s), but only to nodes with a passable edge under
+    // this graph's weights, so a profile view never snaps a route end to a
+    // road it may not use; -1 where no node qualifies
+    int findNearestUsableNode(double lat, double lon) const;
+    std::vector<int> findNearestUsableNodes(const std::vector<std::pair<double, double>>& points) const;
+
+    // True when node u has a passable edge in either direction
+    bool isUsable(int u) const { return usableNodes[u] != 0; }
+
     // Calculate distance (meters) between two node indices
     double calDistance(int id1, int id2) const;
 
+    // Mean Earth radius used by every distance computation
+    static constexpr double EARTH_RADIUS = 6371000.0; // meters
+
     // Haversine formula to compute distance between lat/lon pairs
     static double haversine(double lat1, double lon1, double lat2, double lon2);
 
+    // Metres along a node path, each hop a straight segment
+    double pathMetres(const std::vector<int>& path) const;
+
+    // Cost to an edge weight, rounded up so no path looks cheaper than the
+    // road and straight-line bounds stay admissible
+    static EdgeWeight weightFromCost(double cost) {
+#ifdef OSM_FIXED_POINT_WEIGHTS
+        return (EdgeWeight)std::ceil(cost * WEIGHT_SCALE);
+#else
+        return cost;
+#endif
+    }
+
+    // Search distances in weight units -> cost units
+    static double toCost(Distance d) { return (double)d / WEIGHT_SCALE; }
+
+    // Lowest weight per metre of straight line over all passable edges, so
+    // straight-line distance times this bounds any path's weight from below
+    double costPerMetre() const { return minCostPerMetre; }
+
     // Access node coordinates by index
     double getLat(int index) const;
     double getLon(int index) const;
 
+    // Build-phase id (order of first appearance in the input) of node u, and
+    // the node a build-phase id was renumbered to
+    int originalId(int u) const { return originalIds[u]; }
+    int nodeFromOriginal(int id) const { return originalToNode[id]; }
+
+    // Precomputed unit vector of node u, see UnitVector
+    const UnitVector& unitVector(int u) const { return unitVectors[u]; }
+
     // Store all graph nodes
-    std::vector<Node> nodes;
+    Column<Node> nodes;
 
 private:
+    // Segment queued by addEdge until finalize(); attributes are the
+    // u -> v half's, the v -> u half gets them reversed
+    struct PendingEdge {
+        int u;
+        int v;
+        EdgeWeight forward;
+        EdgeWeight backward;
+        uint16_t attributes;
+        uint32_t way;  // index into pendingWayIds
+    };
+
+    // CSR adjacency: edgeOffsets has numNodes() + 1 entries
+    Column<int> edgeOffsets;
+    Column<int> edgeTargets;
+    Column<EdgeWeight> edgeWeights;
+
+    // Reverse CSR over the same edges, for backward searches
+    Column<int> reverseOffsets;
+    Column<int> reverseSources;
+    Column<int> reverseEdges;
+
+    // EdgeAttributes::pack() per edge, and each edge's entry in wayIds
+    Column<uint16_t> edgeAttrs;
+    Column<uint32_t> edgeWays;
+    Column<int64_t> wayIds;
+
+    // See costPerMetre(), derived from the weights
+    double minCostPerMetre = 0.0;
+
+    // See profile()
+    Profile costProfile = Profile::Car;
+
+    // Build-phase id per node; originalToNode is its inverse
+    Column<int> originalIds;
+    Column<int> originalToNode;
+
+    // Straight line through the Earth between two nodes, from unitVectors
+    double chordMetres(int u, int v) const;
+
+    // Rebuild spatialIndex, unitVectors, originalToNode, minCostPerMetre and
+    // usableNodes after the node set or weights changed
+    void buildNodeIndexes();
+    void computeCostPerMetre();
+    void computeUsableNodes();
+
+    // See isUsable(), derived from the weights
+    Column<uint8_t> usableNodes;
+
+    // Nearest-node lookup, rebuilt whenever the node set changes; shared
+    // with profile views
+    std::shared_ptr<const SpatialIndex> spatialIndex;
+
+    // Per-node trigonometry for straight-line bounds, rebuilt with spatialIndex
+    Column<UnitVector> unitVectors;
+
+    // Keeps a mapped snapshot alive while columns view it
+    std::shared_ptr<const void> mapping;
+
+    // Build-phase state, released by finalize()
+    std::vector<Node> pendingNodes;
+    std::vector<PendingEdge> pendingEdges;
+    std::vector<int64_t> pendingWayIds;  // entry 0 is the unknown way
+
     // Map coordinates to node index for quick lookup
     std::unordered_map<std::pair<double, double>, int, PairHash> coordToIndex;
 };
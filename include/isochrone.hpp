@@ -0,0 +1,43 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+#include "graph.hpp"
+
+// Nodes within a cost budget of a source, cheapest first, with their costs
+// in cost units
+struct ReachableSet {
+    std::vector<int> nodes;
+    std::vector<double> costs;
+    std::size_t nodesVisited = 0;
+};
+
+// Bounded one-to-all Dijkstra on the calling thread's workspace. `out` is
+// overwritten but keeps its capacity, so a caller issuing many searches
+// allocates only for the largest.
+void reachableWithin(const Graph& g, int src, double maxCost, ReachableSet& out);
+
+// Closed ring of corners, first corner repeated at the end
+using Ring = std::vector<Node>;
+
+// Outer ring counter-clockwise, holes clockwise (the GeoJSON winding)
+struct IsoPolygon {
+    Ring outer;
+    std::vector<Ring> holes;
+};
+
+// Area reachable from a source within maxCost
+struct Isochrone {
+    double maxCost = 0.0;
+    std::vector<IsoPolygon> polygons;
+    int reachableNodes = 0;
+};
+
+// One isochrone per entry of maxCosts from a single search up to the
+// largest. Reachable roads, including the reachable part of an edge whose
+// far end is out of budget, are rasterized on a grid of cellMetres squares
+// around the source; each isochrone is the union of the cells they touch,
+// traced into polygons. Cells meeting only at a corner become separate
+// polygons. Buffers live in a per-thread workspace reused across calls.
+std::vector<Isochrone> buildIsochrones(const Graph& g, int src, const std::vector<double>& maxCosts,
+                                       double cellMetres = 100.0);
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+class Graph;
+
+// Landmark distance tables for ALT (A*, Landmarks, Triangle inequality)
+// lower bounds. For a landmark L the triangle inequality gives
+//   d(u, t) >= d(L, t) - d(L, u)   and   d(u, t) >= d(u, L) - d(t, L),
+// which follows the road network far more closely than a straight line.
+// Blocking edges or nodes only makes real distances longer, so the bounds
+// stay valid for Yen's spur searches.
+//
+// Distances are stored as float, node-major, to keep a node's entries on
+// one cache line; a small slack absorbs the rounding so every bound is
+// still a true lower bound.
+class Landmarks {
+public:
+    // Choose `count` landmarks by farthest selection and fill both tables
+    void build(const Graph& g, int count = 16);
+
+    bool empty() const { return landmarks.empty(); }
+    int size() const { return (int)landmarks.size(); }
+    const std::vector<int>& nodes() const { return landmarks; }
+
+    // True when built over a graph with g's node count
+    bool matches(const Graph& g) const;
+
+    // Up to `count` landmarks giving the tightest bound for src -> dest;
+    // a query evaluates only these
+    std::vector<int> select(int src, int dest, int count) const;
+
+    // Lower bound on d(u, t) from the given landmarks
+    double lowerBound(int u, int t, const std::vector<int>& active) const
+    {
+        const float* fu = &fromLandmark[(size_t)u * stride];
+        const float* ft = &fromLandmark[(size_t)t * stride];
+        const float* tu = &toLandmark[(size_t)u * stride];
+        const float* tt = &toLandmark[(size_t)t * stride];
+        double best = 0.0;
+        for (int l : active)
+        {
+            // Unreachable entries are infinite; skip rather than subtract them
+            if (std::isfinite(ft[l]) && std::isfinite(fu[l]))
+                best = std::max(best, (double)ft[l] - fu[l]);
+            if (std::isfinite(tu[l]) && std::isfinite(tt[l]))
+                best = std::max(best, (double)tu[l] - tt[l]);
+        }
+        return best > slack ? best - slack : 0.0;
+    }
+
+private:
+    std::vector<int> landmarks;
+    int stride = 0;
+    std::vector<float> fromLandmark;  // [u * stride + l] = d(landmark l, u)
+    std::vector<float> toLandmark;    // [u * stride + l] = d(u, landmark l)
+    double slack = 0.0;
+};
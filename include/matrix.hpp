@@ -0,0 +1,27 @@
+#pragma once
+
+#include <cstddef>
+#include <limits>
+#include <vector>
+
+class Graph;
+
+// Travel costs between every source and every target, in the graph's cost
+// units (see Graph::toCost), row-major by source
+struct CostMatrix {
+    static constexpr double UNREACHABLE = std::numeric_limits<double>::infinity();
+
+    int sources = 0;
+    int targets = 0;
+    std::vector<double> costs;
+    std::size_t nodesVisited = 0;  // settled nodes over all searches
+
+    double at(int s, int t) const { return costs[(std::size_t)s * targets + t]; }
+};
+
+// One Dijkstra per source, stopped once every target is settled, instead of
+// a search per pair. Sources run in parallel on up to `threads` threads of
+// the shared pool (0 = all), each search on its thread's workspace; a source
+// listed twice is searched once. Unreachable pairs are UNREACHABLE.
+CostMatrix costMatrix(const Graph& g, const std::vector<int>& sources, const std::vector<int>& targets,
+                      int threads = 0);
@@ -0,0 +1,193 @@
+#pragma once
+
+#include <cstdint>
+#include <utility>
+#include <vector>
+#include "graph.hpp"
+
+// Priority queues for the search kernels. Every queue takes (key, node)
+// pairs and pops the smallest key; reset() prepares it for a new search
+// over numNodes nodes and keeps its memory.
+//
+//   BinaryHeap      SearchSpace's own binary heap with lazy deletion: a
+//                   lowered key is pushed again and the stale entry skipped
+//   QuaternaryHeap  indexed 4-ary heap with decrease-key, one entry per node
+//   RadixHeap       monotone radix heap on integer keys (key * RADIX_SCALE)
+enum class QueueKind
+{
+    BinaryHeap,
+    QuaternaryHeap,
+    RadixHeap,
+};
+
+// Heap of arity D that tracks each node's position, so push() on a queued
+// node lowers its key in place instead of adding a duplicate
+template <int D>
+class IndexedDaryHeap
+{
+public:
+    using Entry = std::pair<double, int>;
+
+    void reset(int numNodes)
+    {
+        if ((int)position.size() != numNodes)
+            position.assign(numNodes, -1);
+        else
+            for (const Entry &e : heap)
+                position[e.second] = -1;
+        heap.clear();
+    }
+
+    bool empty() const { return heap.empty(); }
+
+    // Insert v, or lower its key if it is already queued with a larger one
+    void push(double key, int v)
+    {
+        int i = position[v];
+        if (i == -1)
+        {
+            i = (int)heap.size();
+            heap.emplace_back(key, v);
+        }
+        else if (key < heap[i].first)
+        {
+            heap[i].first = key;
+        }
+        else
+        {
+            return;
+        }
+        siftUp(i);
+    }
+
+    Entry pop()
+    {
+        Entry top = heap.front();
+        position[top.second] = -1;
+        Entry last = heap.back();
+        heap.pop_back();
+        if (!heap.empty())
+        {
+            heap[0] = last;
+            position[last.second] = 0;
+            siftDown(0);
+        }
+        return top;
+    }
+
+private:
+    void siftUp(int i)
+    {
+        Entry entry = heap[i];
+        while (i > 0)
+        {
+            int parent = (i - 1) / D;
+            if (heap[parent].first <= entry.first)
+                break;
+            heap[i] = heap[parent];
+            position[heap[i].second] = i;
+            i = parent;
+        }
+        heap[i] = entry;
+        position[entry.second] = i;
+    }
+
+    void siftDown(int i)
+    {
+        const int size = (int)heap.size();
+        Entry entry = heap[i];
+        for (;;)
+        {
+            int first = i * D + 1;
+            if (first >= size)
+                break;
+            int best = first;
+            int last = first + D < size ? first + D : size;
+            for (int c = first + 1; c < last; ++c)
+                if (heap[c].first < heap[best].first)
+                    best = c;
+            if (heap[best].first >= entry.first)
+                break;
+            heap[i] = heap[best];
+            position[heap[i].second] = i;
+            i = best;
+        }
+        heap[i] = entry;
+        position[entry.second] = i;
+    }
+
+    std::vector<Entry> heap;
+    std::vector<int> position;  // index in heap, -1 when not queued
+};
+
+// Radix heap over keys quantized to 1 / RADIX_SCALE weight units, i.e.
+// milliseconds for either weight format. Entries sit in bucket floor(log2(q ^ last)) + 1 relative
+// to the last popped key, so each entry moves down at most 64 times. Keys
+// must not drop below the last popped one; a key that does, e.g. from an
+// inconsistent heuristic, is clamped and its node simply re-opened later.
+// Pops are exact up to one quantum, so a settled distance may exceed the
+// optimum by less than 1 / RADIX_SCALE.
+class RadixHeap
+{
+public:
+    using Entry = std::pair<double, int>;
+    static constexpr double RADIX_SCALE = 1000.0 / WEIGHT_SCALE;
+
+    void reset(int)
+    {
+        for (auto &b : buckets)
+            b.clear();
+        last = 0;
+        count = 0;
+    }
+
+    bool empty() const { return count == 0; }
+
+    void push(double key, int v)
+    {
+        uint64_t q = key > 0.0 ? (uint64_t)(key * RADIX_SCALE) : 0;
+        if (q < last)
+            q = last;
+        buckets[bucketOf(q)].push_back({q, key, v});
+        ++count;
+    }
+
+    Entry pop()
+    {
+        if (buckets[0].empty())
+        {
+            int i = 1;
+            while (buckets[i].empty())
+                ++i;
+            uint64_t minKey = buckets[i][0].q;
+            for (const Item &item : buckets[i])
+                if (item.q < minKey)
+                    minKey = item.q;
+            last = minKey;
+            for (const Item &item : buckets[i])
+                buckets[bucketOf(item.q)].push_back(item);
+            buckets[i].clear();
+        }
+        Item item = buckets[0].back();
+        buckets[0].pop_back();
+        --count;
+        return {item.key, item.v};
+    }
+
+private:
+    struct Item
+    {
+        uint64_t q;
+        double key;
+        int v;
+    };
+
+    int bucketOf(uint64_t q) const
+    {
+        return q == last ? 0 : 64 - __builtin_clzll(q ^ last);
+    }
+
+    std::vector<Item> buckets[65];
+    uint64_t last = 0;
+    size_t count = 0;
+};
@@ -0,0 +1,496 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <memory>
+#include <type_traits>
+#include <vector>
+#include "graph.hpp"
+#include "algorithms.hpp"
+#include "block_set.hpp"
+#include "landmarks.hpp"
+#include "search_workspace.hpp"
+
+// Search kernels specialized at compile time on three policies:
+//
+//   Heuristic  lower bound on the distance left to the target (A* key)
+//   Blocking   which BlockSet checks the inner loop performs
+//   Target     when the search may stop
+//
+// Every engine is one instantiation, so plain Dijkstra makes no heuristic
+// calls and the unblocked first search of Yen's algorithm has no blocking
+// checks at all.
+
+// ---- Heuristics ----------------------------------------------------------
+
+struct NoHeuristic
+{
+    double operator()(int) const { return 0.0; }
+};
+
+// Straight-line (chord) distance to the target times the graph's lowest
+// weight per metre, from the unit vectors the graph precomputes: a few
+// multiplies and one square root per node instead of haversine's
+// trigonometry. No edge costs less per metre of chord and chords obey the
+// triangle inequality, so the bound is admissible whatever the weights
+// measure; the small relative and absolute margins absorb rounding in the
+// vectors.
+struct ChordHeuristic
+{
+    static constexpr int BATCH = 8;
+
+    ChordHeuristic(const Graph &g, int dest) : g(g), t(g.unitVector(dest)), scale(chordScale(g)) {}
+
+    static double chordScale(const Graph &g)
+    {
+        return Graph::EARTH_RADIUS * g.costPerMetre() * (1.0 - 1e-9);
+    }
+
+    double operator()(int u) const
+    {
+        const UnitVector &p = g.unitVector(u);
+        return bound(p.x - t.x, p.y - t.y, p.z - t.z);
+    }
+
+    // Bounds for count <= BATCH nodes at once. Gathering first leaves a
+    // branch-free loop the compiler vectorizes.
+    void batch(const int *nodes, int count, double *out) const
+    {
+        double dx[BATCH], dy[BATCH], dz[BATCH];
+        for (int i = 0; i < count; ++i)
+        {
+            const UnitVector &p = g.unitVector(nodes[i]);
+            dx[i] = p.x - t.x;
+            dy[i] = p.y - t.y;
+            dz[i] = p.z - t.z;
+        }
+        for (int i = 0; i < count; ++i)
+            out[i] = bound(dx[i], dy[i], dz[i]);
+    }
+
+    double bound(double dx, double dy, double dz) const
+    {
+        return bound(dx, dy, dz, scale);
+    }
+
+    static double bound(double dx, double dy, double dz, double scale)
+    {
+        constexpr double slack = 1e-6 * WEIGHT_SCALE;
+        return std::sqrt(dx * dx + dy * dy + dz * dz) * scale - slack;
+    }
+
+    const Graph &g;
+    UnitVector t;
+    double scale;
+};
+
+// ALT bound from the landmarks that best separate src and dest, never
+// weaker than the straight line
+struct LandmarkHeuristic
+{
+    LandmarkHeuristic(const Graph &g, const Landmarks &landmarks, int src, int dest, int activeCount)
+        : straightLine(g, dest), landmarks(landmarks), dest(dest),
+          active(landmarks.select(src, dest, activeCount)) {}
+
+    double operator()(int u) const
+    {
+        return std::max(landmarks.lowerBound(u, dest, active), straightLine(u));
+    }
+
+    ChordHeuristic straightLine;
+    const Landmarks &landmarks;
+    int dest;
+    std::vector<int> active;
+};
+
+// Heuristics with a batch(nodes, count, out) member bound the improved
+// neighbours of a settled node together, BATCH at a time
+template <typename Heuristic, typename = void>
+struct HasBatch : std::false_type
+{
+};
+
+template <typename Heuristic>
+struct HasBatch<Heuristic, std::void_t<decltype(std::declval<const Heuristic &>().batch(nullptr, 0, nullptr))>>
+    : std::true_type
+{
+};
+
+// ---- Blocking ------------------------------------------------------------
+
+template <bool Nodes, bool Edges>
+struct Blocking
+{
+    const BlockSet *set = nullptr;
+
+    bool node(int v) const
+    {
+        if constexpr (Nodes)
+            return set->nodeBlocked(v);
+        else
+            return false;
+    }
+    bool edge(int e) const
+    {
+        if constexpr (Edges)
+            return set->edgeBlocked(e);
+        else
+            return false;
+    }
+    void check(const Graph &g) const
+    {
+        if constexpr (Nodes || Edges)
+            set->requireSizedFor(g);
+    }
+};
+
+using NoBlocking = Blocking<false, false>;
+using NodeBlocking = Blocking<true, false>;
+using EdgeBlocking = Blocking<false, true>;
+using NodeEdgeBlocking = Blocking<true, true>;
+
+// ---- Targets -------------------------------------------------------------
+
+struct SingleTarget
+{
+    int dest;
+    bool done(int settled) { return settled == dest; }
+};
+
+// Stops once every listed node is settled. Built once per target list and
+// rearmed for each search, so repeated one-to-many queries skip the setup.
+// Copies share the read-only target flags and count down on their own, so
+// concurrent searches each take a copy.
+class ManyTargets
+{
+public:
+    ManyTargets(int numNodes, const std::vector<int> &targets)
+    {
+        auto flags = std::make_shared<std::vector<char>>(numNodes, 0);
+        for (int t : targets)
+        {
+            if (!(*flags)[t])
+                ++distinct;
+            (*flags)[t] = 1;
+        }
+        isTarget = flags->data();
+        owner = std::move(flags);
+        rearm();
+    }
+
+    void rearm() { remaining = distinct; }
+
+    bool done(int settled)
+    {
+        if (remaining == 0)
+            return true;
+        return isTarget[settled] && --remaining == 0;
+    }
+
+private:
+    std::shared_ptr<const std::vector<char>> owner;
+    const char *isTarget = nullptr;  // owner's flags
+    int distinct = 0;
+    int remaining = 0;
+};
+
+// Bounded one-to-all: stops at the first node costlier than `limit` and
+// appends every node settled before it to `settled`, cheapest first
+struct WithinCost
+{
+    const SearchSpace &space;
+    Distance limit;
+    std::vector<int> &settled;
+
+    bool done(int u)
+    {
+        if (space.dist(u) > limit)
+            return true;
+        settled.push_back(u);
+        return false;
+    }
+};
+
+// ---- Queues --------------------------------------------------------------
+
+// SearchSpace's built-in lazy binary heap behind the queue interface of
+// priority_queues.hpp; SearchSpace::reset already empties it
+struct SpaceHeap
+{
+    SearchSpace &space;
+
+    void reset(int) {}
+    bool empty() const { return space.empty(); }
+    void push(double key, int v) { space.push(key, v); }
+    SearchSpace::QueueEntry pop() { return space.pop(); }
+};
+
+// ---- Kernels -------------------------------------------------------------
+
+// Forward search from src into `space`, ordered by `queue`; returns the
+// number of settled nodes. With a heuristic this is A*, which re-opens
+// nodes when a shorter path turns up, so the heuristic only needs to be
+// admissible. Distances and parents stay in `space` for the caller to read.
+template <typename Heuristic, typename BlockPolicy, typename Target, typename Queue>
+size_t searchKernel(const Graph &g, SearchSpace &space, Queue &queue, int src,
+                    const Heuristic &heuristic, const BlockPolicy &blocking, Target &target)
+{
+    static_assert((!std::is_same_v<Target, ManyTargets> && !std::is_same_v<Target, WithinCost>) ||
+                      std::is_same_v<Heuristic, NoHeuristic>,
+                  "a heuristic targets one node; many-target searches must use NoHeuristic");
+
+    blocking.check(g);
+    space.reset(g.numNodes());
+    queue.reset(g.numNodes());
+    size_t nodeVisited = 0;
+
+    double h = heuristic(src);
+    space.update(src, 0.0, h, -1);
+    queue.push(h, src);
+
+    while (!queue.empty())
+    {
+        auto [key, u] = queue.pop();
+
+        if (key > space.key(u))
+            continue;
+        if (target.done(u))
+            break;
+        if (blocking.node(u))
+            continue;
+
+        ++nodeVisited;
+
+        Distance du = space.dist(u);
+        if constexpr (HasBatch<Heuristic>::value)
+        {
+            // Collect improved neighbours, bound them together, then update.
+            // A multi-edge may improve a node twice; the recheck keeps the best.
+            constexpr int BATCH = Heuristic::BATCH;
+            int improved[BATCH];
+            Distance improvedDist[BATCH];
+            double bounds[BATCH];
+            int count = 0;
+            auto flush = [&]()
+            {
+                heuristic.batch(improved, count, bounds);
+                for (int i = 0; i < count; ++i)
+                {
+                    int v = improved[i];
+                    if (improvedDist[i] < space.dist(v))
+                    {
+                        double kv = improvedDist[i] + bounds[i];
+                        space.update(v, improvedDist[i], kv, u);
+                        queue.push(kv, v);
+                    }
+                }
+                count = 0;
+            };
+            for (int e = g.edgeBegin(u), end = g.edgeEnd(u); e < end; ++e)
+            {
+                int v = g.edgeTarget(e);
+                if (blocking.node(v))
+                    continue;
+                if (blocking.edge(e))
+                    continue;
+                EdgeWeight w = g.edgeWeight(e);
+                if (!isPassable(w))
+                    continue;
+
+                Distance nd = du + w;
+                if (nd < space.dist(v))
+                {
+                    improved[count] = v;
+                    improvedDist[count] = nd;
+                    if (++count == BATCH)
+                        flush();
+                }
+            }
+            if (count > 0)
+                flush();
+        }
+        else
+        {
+            for (int e = g.edgeBegin(u), end = g.edgeEnd(u); e < end; ++e)
+            {
+                int v = g.edgeTarget(e);
+                if (blocking.node(v))
+                    continue;
+                if (blocking.edge(e))
+                    continue;
+                EdgeWeight w = g.edgeWeight(e);
+                if (!isPassable(w))
+                    continue;
+
+                Distance nd = du + w;
+                if (nd < space.dist(v))
+                {
+                    double kv = nd + heuristic(v);
+                    space.update(v, nd, kv, u);
+                    queue.push(kv, v);
+                }
+            }
+        }
+    }
+    return nodeVisited;
+}
+
+// Point-to-point search on this thread's workspace with the chosen queue
+template <typename Heuristic, typename BlockPolicy>
+PathResult shortestPath(const Graph &g, int src, int dest,
+                        const Heuristic &heuristic, const BlockPolicy &blocking,
+                        QueueKind queueKind = QueueKind::BinaryHeap)
+{
+    SearchWorkspace &workspace = SearchWorkspace::local();
+    SearchSpace &space = workspace.forward;
+    SingleTarget target{dest};
+    size_t nodeVisited = 0;
+    switch (queueKind)
+    {
+    case QueueKind::QuaternaryHeap:
+        nodeVisited = searchKernel(g, space, workspace.quaternaryHeap, src, heuristic, blocking, target);
+        break;
+    case QueueKind::RadixHeap:
+        nodeVisited = searchKernel(g, space, workspace.radixHeap, src, heuristic, blocking, target);
+        break;
+    default:
+    {
+        SpaceHeap heap{space};
+        nodeVisited = searchKernel(g, space, heap, src, heuristic, blocking, target);
+    }
+    }
+    if (!space.reached(dest))
+        return {{}, 0.0, nodeVisited};
+    return {space.pathTo(dest), Graph::toCost(space.dist(dest)), nodeVisited};
+}
+
+// Bidirectional search shared by the Dijkstra and A* variants. `potential`
+// is the forward potential pf; the backward search uses -pf, so both
+// directions work on the same reduced edge costs w(u, v) - pf(u) + pf(v).
+// With a consistent pf the search may stop once the two queue minima sum
+// to at least the best meeting length mu.
+template <typename Potential, typename BlockPolicy>
+PathResult bidirectionalKernel(const Graph &g, int src, int dest,
+                               const Potential &potential, const BlockPolicy &blocking)
+{
+    const int n = g.numNodes();
+
+    blocking.check(g);
+    if (src == dest)
+        return {{src}, 0.0, 0};
+
+    SearchWorkspace &workspace = SearchWorkspace::local();
+    workspace.forward.reset(n);
+    workspace.backward.reset(n);
+    size_t nodeVisited = 0;
+
+    workspace.forward.update(src, 0.0, potential(src), -1);
+    workspace.forward.push(potential(src), src);
+    workspace.backward.update(dest, 0.0, -potential(dest), -1);
+    workspace.backward.push(-potential(dest), dest);
+
+    Distance mu = INF_DISTANCE;
+    int meet = -1;
+
+    while (!workspace.forward.empty() && !workspace.backward.empty())
+    {
+        double topF = workspace.forward.top().first;
+        double topB = workspace.backward.top().first;
+        if (topF + topB >= mu)
+            break;
+
+        // Expand the side whose frontier is closer
+        bool forward = topF <= topB;
+        SearchSpace &space = forward ? workspace.forward : workspace.backward;
+        const SearchSpace &other = forward ? workspace.backward : workspace.forward;
+
+        auto [key, u] = space.pop();
+
+        if (key > space.key(u))
+            continue;
+        if (blocking.node(u))
+            continue;
+
+        ++nodeVisited;
+
+        Distance du = space.dist(u);
+        auto relax = [&](int v, EdgeWeight weight)
+        {
+            Distance nd = du + weight;
+            if (nd < space.dist(v))
+            {
+                double pv = potential(v);
+                double kv = nd + (forward ? pv : -pv);
+                space.update(v, nd, kv, u);
+                space.push(kv, v);
+            }
+            Distance through = space.dist(v) + other.dist(v);
+            if (through < mu)
+            {
+                mu = through;
+                meet = v;
+            }
+        };
+
+        if (forward)
+        {
+            for (int e = g.edgeBegin(u), end = g.edgeEnd(u); e < end; ++e)
+            {
+                int v = g.edgeTarget(e);
+                if (blocking.node(v))
+                    continue;
+                if (blocking.edge(e))
+                    continue;
+                EdgeWeight w = g.edgeWeight(e);
+                if (isPassable(w))
+                    relax(v, w);
+            }
+        }
+        else
+        {
+            for (int r = g.reverseBegin(u), end = g.reverseEnd(u); r < end; ++r)
+            {
+                int v = g.reverseSource(r);
+                int e = g.reverseEdge(r);
+                if (blocking.node(v))
+                    continue;
+                if (blocking.edge(e))
+                    continue;
+                EdgeWeight w = g.edgeWeight(e);
+                if (isPassable(w))
+                    relax(v, w);
+            }
+        }
+    }
+
+    std::vector<int> path;
+    if (meet != -1)
+    {
+        path = workspace.forward.pathTo(meet);
+        for (int cur = workspace.backward.parent(meet); cur != -1; cur = workspace.backward.parent(cur))
+            path.emplace_back(cur);
+    }
+
+    return {std::move(path), meet == -1 ? 0.0 : Graph::toCost(mu), nodeVisited};
+}
+
+// Average of the distance-to-target and distance-from-source chord bounds
+// in weight units, consistent in both directions
+struct AveragePotential
+{
+    AveragePotential(const Graph &g, int src, int dest)
+        : g(g), s(g.unitVector(src)), t(g.unitVector(dest)), scale(ChordHeuristic::chordScale(g)) {}
+
+    double operator()(int u) const
+    {
+        const UnitVector &p = g.unitVector(u);
+        return 0.5 * (ChordHeuristic::bound(p.x - t.x, p.y - t.y, p.z - t.z, scale) -
+                      ChordHeuristic::bound(p.x - s.x, p.y - s.y, p.z - s.z, scale));
+    }
+
+    const Graph &g;
+    UnitVector s;
+    UnitVector t;
+    double scale;
+};
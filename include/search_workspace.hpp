@@ -0,0 +1,106 @@
+#pragma once
+
+#include <vector>
+#include <utility>
+#include <limits>
+#include <cstdint>
+#include <algorithm>
+#include <functional>
+#include "block_set.hpp"
+#include "priority_queues.hpp"
+
+// Per-node search state. A label is only meaningful when its stamp matches
+// the owning SearchSpace's generation; anything else reads as unreached.
+struct SearchLabel
+{
+    Distance dist;
+    double key;
+    int parent;
+    uint32_t stamp;
+};
+
+// One search direction: labels plus the priority queue storage. reset()
+// starts a new search in O(1) by bumping the generation, so a query only
+// pays for the nodes it touches and the vectors keep their capacity.
+class SearchSpace
+{
+public:
+    using QueueEntry = std::pair<double, int>;
+
+    void reset(int numNodes)
+    {
+        if ((int)labels.size() != numNodes)
+        {
+            labels.assign(numNodes, {0, 0.0, -1, 0});
+            generation = 0;
+        }
+        if (++generation == 0)
+        {
+            // Stamps wrapped around: clear them once and start over
+            for (auto &l : labels)
+                l.stamp = 0;
+            generation = 1;
+        }
+        heap.clear();
+    }
+
+    bool reached(int v) const { return labels[v].stamp == generation; }
+    Distance dist(int v) const { return reached(v) ? labels[v].dist : INF_DISTANCE; }
+    double key(int v) const { return reached(v) ? labels[v].key : std::numeric_limits<double>::infinity(); }
+    int parent(int v) const { return reached(v) ? labels[v].parent : -1; }
+
+    void update(int v, Distance dist, double key, int parent)
+    {
+        labels[v] = {dist, key, parent, generation};
+    }
+
+    // Min-queue on key with lazy deletion
+    bool empty() const { return heap.empty(); }
+    const QueueEntry &top() const { return heap.front(); }
+    void push(double key, int v)
+    {
+        heap.emplace_back(key, v);
+        std::push_heap(heap.begin(), heap.end(), std::greater<>());
+    }
+    QueueEntry pop()
+    {
+        std::pop_heap(heap.begin(), heap.end(), std::greater<>());
+        QueueEntry entry = heap.back();
+        heap.pop_back();
+        return entry;
+    }
+
+    // Nodes from the search root to v following parent links
+    std::vector<int> pathTo(int v) const
+    {
+        std::vector<int> path;
+        for (int cur = v; cur != -1; cur = parent(cur))
+            path.emplace_back(cur);
+        std::reverse(path.begin(), path.end());
+        return path;
+    }
+
+private:
+    std::vector<SearchLabel> labels;
+    std::vector<QueueEntry> heap;
+    uint32_t generation = 0;
+};
+
+// Scratch state for one thread's searches; bidirectional engines use both
+// spaces, Yen's algorithm fills `blocks` for its spur searches and the
+// standalone queues serve kernels that ask for them. local() hands out a
+// thread_local instance so repeated queries reuse the same memory.
+struct SearchWorkspace
+{
+    SearchSpace forward;
+    SearchSpace backward;
+    BlockSet blocks;
+    IndexedDaryHeap<4> quaternaryHeap;
+    RadixHeap radixHeap;
+
+    static SearchWorkspace &local()
+    {
+        thread_local SearchWorkspace workspace;
+        return workspace;
+    }
+};
@@ -0,0 +1,40 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+struct Node;
+
+// Static k-d tree over node positions on the unit sphere. Straight-line
+// (chord) distance between unit vectors grows monotonically with the
+// great-circle distance, so the nearest point in 3D is also the nearest
+// node by haversine. The tree is implicit: each range [lo, hi) stores its
+// splitting point at the midpoint of a flat array.
+class SpatialIndex {
+public:
+    // Build over node coordinates, O(N log N)
+    void build(const Node* nodes, std::size_t count);
+
+    // Exact nearest node id to (lat, lon), -1 if the index is empty.
+    // Ties go to the smallest node id, as with a linear scan. With `usable`,
+    // only ids whose entry is nonzero qualify (-1 if none does).
+    int nearest(double lat, double lon, const unsigned char* usable = nullptr) const;
+
+    bool empty() const { return points.empty(); }
+
+    // Unit vector for a latitude/longitude in degrees
+    static void toUnitVector(double lat, double lon, double out[3]);
+
+private:
+    struct KdPoint {
+        double xyz[3];
+        int id;
+        int axis;
+    };
+
+    void buildRange(int lo, int hi);
+    void searchRange(int lo, int hi, const double q[3], const unsigned char* usable, double& bestDist2,
+                     int& bestId) const;
+
+    std::vector<KdPoint> points;
+};
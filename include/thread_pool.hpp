@@ -0,0 +1,46 @@
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <thread>
+#include <vector>
+#include <deque>
+#include <mutex>
+#include <condition_variable>
+
+// Fixed set of worker threads for data-parallel loops. parallelFor hands out
+// indices from a shared counter, so uneven tasks balance themselves, and the
+// calling thread works through the loop too: a parallelFor issued from inside
+// another one still finishes even when every worker is busy.
+//
+// WebAssembly builds without pthreads get a pool of size 0 and every loop
+// runs inline on the caller.
+class ThreadPool {
+public:
+    explicit ThreadPool(unsigned threads);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    // Worker threads, not counting callers of parallelFor
+    unsigned size() const { return (unsigned)workers.size(); }
+
+    // Run fn(i) for every i in [0, count) on up to maxThreads threads
+    // (0 = no limit) and return once all calls are done. The first
+    // exception thrown by fn is rethrown here.
+    void parallelFor(std::size_t count, const std::function<void(std::size_t)>& fn,
+                     unsigned maxThreads = 0);
+
+    // Process-wide pool with one worker per hardware thread beyond the caller's
+    static ThreadPool& shared();
+
+private:
+    void workerLoop();
+
+    std::vector<std::thread> workers;
+    std::deque<std::function<void()>> tasks;
+    std::mutex mutex;
+    std::condition_variable wake;
+    bool stopping = false;
+};
@@ -0,0 +1,211 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <limits>
+#include <queue>
+#include <set>
+#include <type_traits>
+#include <vector>
+#include <sys/resource.h>
+#include "graph.hpp"
+#include "algorithms.hpp"
+#include "block_set.hpp"
+#include "search_workspace.hpp"
+#include "thread_pool.hpp"
+
+namespace yen_detail
+{
+
+inline size_t peakMemoryKB()
+{
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_maxrss;
+}
+
+// Cost along consecutive path nodes (cheapest passable edge per hop)
+inline double pathLength(const Graph &g, const std::vector<int> &path)
+{
+    Distance length = 0;
+    for (size_t i = 0; i + 1 < path.size(); ++i)
+    {
+        int e = g.cheapestEdge(path[i], path[i + 1]);
+        if (e != -1)
+            length += g.edgeWeight(e);
+    }
+    return Graph::toCost(length);
+}
+
+// Unblocked search for the first route: kernels with a (g, src, dest)
+// overload get their unblocked instantiation, plain functions an empty BlockSet
+template <typename Kernel>
+PathResult firstSearch(const Kernel &kernel, const Graph &g, int src, int dest)
+{
+    if constexpr (std::is_invocable_r_v<PathResult, const Kernel &, const Graph &, int, int>)
+    {
+        return kernel(g, src, dest);
+    }
+    else
+    {
+        BlockSet &noBlocks = SearchWorkspace::local().blocks;
+        noBlocks.reset(g);
+        return kernel(g, src, dest, noBlocks);
+    }
+}
+
+} // namespace yen_detail
+
+// Yen's K shortest loopless paths, specialized on the search engine. Kernel
+// is any callable kernel(g, src, dest, const BlockSet&) -> PathResult, such
+// as DijkstraKernel or a ShortestPathFunc; see algorithms.hpp.
+template <typename Kernel>
+KPathsResult yenKShortestPaths(const Graph &g, int src, int dest, const Kernel &kernel,
+                               const YenOptions &options = {})
+{
+    using yen_detail::pathLength;
+
+    auto t0 = std::chrono::steady_clock::now();
+    KPathsResult result;
+    const int k = options.k > 0 ? options.k : 4;
+
+    auto outOfTime = [&]()
+    {
+        if (options.timeBudgetMS <= 0.0)
+            return false;
+        auto now = std::chrono::steady_clock::now();
+        return std::chrono::duration<double, std::milli>(now - t0).count() > options.timeBudgetMS;
+    };
+
+    // Step 1: Get the first shortest path
+    PathResult firstPath = yen_detail::firstSearch(kernel, g, src, dest);
+    if (firstPath.path.empty())
+        return result;
+
+    // Calculate length of first path
+    firstPath.length = pathLength(g, firstPath.path);
+    result.paths.push_back(firstPath);
+
+    // Routes longer than this are never returned, so neither candidates nor
+    // spur searches beyond it are worth computing
+    const double maxLength = options.maxDetourRatio > 0.0
+                                 ? firstPath.length * options.maxDetourRatio
+                                 : std::numeric_limits<double>::infinity();
+
+    // Every path already accepted or queued, so no route is returned twice
+    std::set<std::vector<int>> seen;
+    seen.insert(firstPath.path);
+
+    // Min-heap for candidate paths
+    using Candidate = std::pair<double, PathResult>;
+    auto cmp = [](const Candidate &a, const Candidate &b)
+    { return a.first > b.first; };
+    std::priority_queue<Candidate, std::vector<Candidate>, decltype(cmp)> candidates(cmp);
+
+    // Step 2: Generate K-1 more paths
+    bool stopped = false;
+    for (int found = 1; found < k && !stopped; ++found)
+    {
+        const PathResult &lastPath = result.paths.back();
+
+        // Root lengths only grow along the path, so spurs whose root alone
+        // reaches the detour bound are cut off up front
+        size_t spurCount = 0;
+        double rootLength = 0.0;
+        while (spurCount + 1 < lastPath.path.size())
+        {
+            if (spurCount > 0)
+                rootLength += Graph::toCost(g.edgeWeight(g.cheapestEdge(lastPath.path[spurCount - 1], lastPath.path[spurCount])));
+            if (rootLength >= maxLength)
+                break;
+            ++spurCount;
+        }
+
+        // Spur searches are independent: each fills its thread's BlockSet and
+        // searches in its thread's workspace. Results land in per-spur slots
+        // and are merged in path order below, so the outcome is the same for
+        // any thread count.
+        std::vector<PathResult> spurPaths(spurCount);
+        std::atomic<bool> interrupted{false};
+        auto spurSearch = [&](size_t i)
+        {
+            if (interrupted.load(std::memory_order_relaxed))
+                return;
+            if (outOfTime())
+            {
+                interrupted = true;
+                return;
+            }
+
+            int spurNode = lastPath.path[i];
+            BlockSet &blocked = SearchWorkspace::local().blocks;
+            blocked.reset(g);
+
+            for (const auto &p : result.paths)
+            {
+                if (p.path.size() > i && std::equal(lastPath.path.begin(), lastPath.path.begin() + i + 1, p.path.begin()))
+                    blocked.blockEdgesBetween(g, p.path[i], p.path[i + 1]);
+            }
+
+            for (size_t r = 0; r < i; ++r)
+                blocked.blockNode(lastPath.path[r]);
+
+            spurPaths[i] = kernel(g, spurNode, dest, blocked);
+        };
+
+        if (options.threads == 1)
+        {
+            for (size_t i = 0; i < spurCount; ++i)
+                spurSearch(i);
+        }
+        else
+        {
+            ThreadPool::shared().parallelFor(spurCount, spurSearch, options.threads > 0 ? options.threads : 0);
+        }
+        stopped = interrupted.load();
+
+        for (size_t i = 0; i < spurCount && !stopped; ++i)
+        {
+            const PathResult &spurPath = spurPaths[i];
+            if (!spurPath.path.empty())
+            {
+                std::vector<int> totalPath(lastPath.path.begin(), lastPath.path.begin() + i);
+                totalPath.insert(totalPath.end(), spurPath.path.begin(), spurPath.path.end());
+
+                double totalLength = pathLength(g, totalPath);
+                if (totalLength > maxLength || !seen.insert(totalPath).second)
+                    continue;
+
+                // IMPORTANT: Set the length property for the PathResult
+                PathResult candidatePath;
+                candidatePath.path = std::move(totalPath);
+                candidatePath.length = totalLength; // ← ADDED: Set length property
+
+                candidates.emplace(totalLength, candidatePath);
+            }
+        }
+
+        // An interrupted round may not have seen the best candidate yet
+        if (stopped || candidates.empty())
+            break;
+
+        // Ensure the selected path has length property set
+        PathResult selectedPath = candidates.top().second;
+        // Length should already be set above, but double-check
+        if (selectedPath.length == 0.0 && selectedPath.path.size() > 1)
+        {
+            // Recalculate length if somehow missing
+            selectedPath.length = pathLength(g, selectedPath.path);
+        }
+
+        result.paths.push_back(selectedPath);
+        candidates.pop();
+    }
+
+    auto t1 = std::chrono::steady_clock::now();
+    result.timeMS = std::chrono::duration<double, std::milli>(t1 - t0).count();
+    result.memoryUsage = yen_detail::peakMemoryKB();
+
+    return result;
+}
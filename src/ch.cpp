@@ -0,0 +1,582 @@
+// ch.cpp
+#include "ch.hpp"
+#include "search_workspace.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <queue>
+#include <stdexcept>
+
+static constexpr char CH_MAGIC[8] = {'O', 'S', 'M', 'C', 'H', '\0', '\0', '\0'};
+static constexpr uint32_t CH_VERSION = 4;
+
+// Witness searches give up after settling this many nodes; a missed
+// witness only costs a redundant shortcut, never a wrong answer
+static constexpr int WITNESS_SETTLE_LIMIT = 500;
+
+namespace
+{
+
+struct Arc
+{
+    int other;
+    int edge;
+};
+
+// Mutable overlay graph used while contracting. Arcs to contracted nodes
+// are dropped lazily.
+class Contractor
+{
+public:
+    Contractor(int n, std::vector<int> &rank, std::vector<std::vector<int>> &upLists,
+               std::vector<std::vector<int>> &downLists)
+        : out(n), in(n), contracted(n, 0), deletedNeighbors(n, 0),
+          rank(rank), upLists(upLists), downLists(downLists)
+    {
+    }
+
+    struct EdgeRec
+    {
+        int from, to;
+        Distance weight;
+        int childA, childB;
+    };
+    std::vector<EdgeRec> edges;
+
+    // Insert u -> w unless an equal or cheaper arc already exists; a
+    // cheaper new edge replaces the arc (the old edge stays in the arena
+    // because older shortcuts may reference it)
+    void addEdge(int u, int w, Distance weight, int childA, int childB)
+    {
+        for (Arc &a : out[u])
+        {
+            if (a.other != w)
+                continue;
+            if (edges[a.edge].weight <= weight)
+                return;
+            int id = newEdge(u, w, weight, childA, childB);
+            a.edge = id;
+            for (Arc &b : in[w])
+                if (b.other == u)
+                    b.edge = id;
+            return;
+        }
+        int id = newEdge(u, w, weight, childA, childB);
+        out[u].push_back({w, id});
+        in[w].push_back({u, id});
+    }
+
+    void contractAll()
+    {
+        const int n = (int)out.size();
+        priority.resize(n);
+        using PQ = std::pair<int, int>;
+        std::priority_queue<PQ, std::vector<PQ>, std::greater<>> queue;
+        for (int v = 0; v < n; ++v)
+        {
+            priority[v] = computePriority(v);
+            queue.emplace(priority[v], v);
+        }
+
+        int nextRank = 0;
+        while (!queue.empty())
+        {
+            auto [p, v] = queue.top();
+            queue.pop();
+            if (contracted[v] || p != priority[v])
+                continue;
+
+            // Lazy update: re-evaluate and defer if no longer the minimum
+            int fresh = computePriority(v);
+            if (!queue.empty() && fresh > queue.top().first)
+            {
+                priority[v] = fresh;
+                queue.emplace(fresh, v);
+                continue;
+            }
+
+            contract(v, false);
+            rank[v] = nextRank++;
+
+            for (const Arc &a : out[v])
+                touchNeighbor(a.other, queue);
+            for (const Arc &a : in[v])
+                touchNeighbor(a.other, queue);
+            out[v].clear();
+            in[v].clear();
+        }
+    }
+
+private:
+    int newEdge(int u, int w, Distance weight, int childA, int childB)
+    {
+        edges.push_back({u, w, weight, childA, childB});
+        return (int)edges.size() - 1;
+    }
+
+    void touchNeighbor(int u, std::priority_queue<std::pair<int, int>, std::vector<std::pair<int, int>>, std::greater<>> &queue)
+    {
+        if (contracted[u])
+            return;
+        ++deletedNeighbors[u];
+        priority[u] = computePriority(u);
+        queue.emplace(priority[u], u);
+    }
+
+    void pruneArcs(int v)
+    {
+        auto gone = [&](const Arc &a)
+        { return contracted[a.other] != 0; };
+        out[v].erase(std::remove_if(out[v].begin(), out[v].end(), gone), out[v].end());
+        in[v].erase(std::remove_if(in[v].begin(), in[v].end(), gone), in[v].end());
+    }
+
+    // Edge difference plus the contracted-neighbor count, which spreads
+    // contraction evenly over the graph
+    int computePriority(int v)
+    {
+        pruneArcs(v);
+        int shortcuts = contract(v, true);
+        return shortcuts - (int)(out[v].size() + in[v].size()) + deletedNeighbors[v];
+    }
+
+    // Shortcuts needed to contract v; they are only added when !simulate
+    int contract(int v, bool simulate)
+    {
+        if (!simulate)
+        {
+            pruneArcs(v);
+            contracted[v] = 1;
+            for (const Arc &a : out[v])
+                upLists[v].push_back(a.edge);
+            for (const Arc &a : in[v])
+                downLists[v].push_back(a.edge);
+        }
+
+        int shortcuts = 0;
+        for (const Arc &inArc : in[v])
+        {
+            int u = inArc.other;
+            Distance wu = edges[inArc.edge].weight;
+            Distance maxTarget = 0;
+            for (const Arc &outArc : out[v])
+            {
+                if (outArc.other != u)
+                    maxTarget = std::max(maxTarget, wu + edges[outArc.edge].weight);
+            }
+            if (maxTarget == 0)
+                continue;
+
+            witnessSearch(u, v, maxTarget);
+
+            for (const Arc &outArc : out[v])
+            {
+                int w = outArc.other;
+                if (w == u)
+                    continue;
+                Distance via = wu + edges[outArc.edge].weight;
+                if (witness.dist(w) <= via)
+                    continue;
+                ++shortcuts;
+                if (!simulate)
+                    addEdge(u, w, via, inArc.edge, outArc.edge);
+            }
+        }
+        return shortcuts;
+    }
+
+    // Bounded Dijkstra from u over uncontracted nodes, avoiding v
+    void witnessSearch(int u, int v, Distance maxDist)
+    {
+        witness.reset((int)out.size());
+        witness.update(u, 0.0, 0.0, -1);
+        witness.push(0.0, u);
+        int settled = 0;
+        while (!witness.empty())
+        {
+            auto [key, x] = witness.pop();
+            if (key > witness.key(x))
+                continue;
+            Distance d = witness.dist(x);
+            if (d > maxDist || ++settled > WITNESS_SETTLE_LIMIT)
+                break;
+            for (const Arc &a : out[x])
+            {
+                int y = a.other;
+                if (y == v || contracted[y])
+                    continue;
+                Distance nd = d + edges[a.edge].weight;
+                if (nd < witness.dist(y))
+                {
+                    witness.update(y, nd, nd, x);
+                    witness.push(nd, y);
+                }
+            }
+        }
+    }
+
+    std::vector<std::vector<Arc>> out;
+    std::vector<std::vector<Arc>> in;
+    std::vector<char> contracted;
+    std::vector<int> deletedNeighbors;
+    std::vector<int> priority;
+    SearchSpace witness;
+
+    std::vector<int> &rank;
+    std::vector<std::vector<int>> &upLists;
+    std::vector<std::vector<int>> &downLists;
+};
+
+void toCSR(const std::vector<std::vector<int>> &lists, std::vector<int> &offsets, std::vector<int> &ids)
+{
+    offsets.assign(lists.size() + 1, 0);
+    for (size_t i = 0; i < lists.size(); ++i)
+        offsets[i + 1] = offsets[i] + (int)lists[i].size();
+    ids.clear();
+    ids.reserve(offsets.back());
+    for (const auto &l : lists)
+        ids.insert(ids.end(), l.begin(), l.end());
+}
+
+template <typename T>
+void writeVector(std::ofstream &out, const std::vector<T> &v)
+{
+    uint64_t count = v.size();
+    out.write(reinterpret_cast<const char *>(&count), sizeof(count));
+    out.write(reinterpret_cast<const char *>(v.data()), count * sizeof(T));
+}
+
+template <typename T>
+void readVector(std::ifstream &in, std::vector<T> &v)
+{
+    uint64_t count = 0;
+    in.read(reinterpret_cast<char *>(&count), sizeof(count));
+    if (!in || count > (1ull << 34))
+        throw std::runtime_error("Invalid hierarchy file: bad array length");
+    v.resize(count);
+    in.read(reinterpret_cast<char *>(v.data()), count * sizeof(T));
+}
+
+// FNV-1a over the adjacency, node numbering and edge weights, so a
+// hierarchy is not reused for a graph with the same counts but different
+// ids or costs
+uint64_t fingerprintOf(const Graph &g)
+{
+    uint64_t hash = 14695981039346656037ull;
+    auto mix = [&](int64_t value)
+    {
+        for (int i = 0; i < 8; ++i)
+        {
+            hash ^= (uint64_t)(value >> (8 * i)) & 0xff;
+            hash *= 1099511628211ull;
+        }
+    };
+    for (int u = 0; u < g.numNodes(); ++u)
+    {
+        mix(g.originalId(u));
+        for (int e = g.edgeBegin(u); e < g.edgeEnd(u); ++e)
+        {
+            EdgeWeight w = g.edgeWeight(e);
+            int64_t bits = 0;
+            std::memcpy(&bits, &w, sizeof(w));
+            mix(g.edgeTarget(e));
+            mix(bits);
+        }
+        mix(-1);
+    }
+    return hash;
+}
+
+} // namespace
+
+void ContractionHierarchy::build(const Graph &g)
+{
+    auto t0 = std::chrono::steady_clock::now();
+    const int n = g.numNodes();
+
+    rank.assign(n, -1);
+    std::vector<std::vector<int>> upLists(n), downLists(n);
+    Contractor contractor(n, rank, upLists, downLists);
+
+    for (int u = 0; u < n; ++u)
+    {
+        for (int e = g.edgeBegin(u); e < g.edgeEnd(u); ++e)
+        {
+            int v = g.edgeTarget(e);
+            if (v != u && isPassable(g.edgeWeight(e)))
+                contractor.addEdge(u, v, g.edgeWeight(e), -1, -1);
+        }
+    }
+    graphEdges = contractor.edges.size();
+
+    contractor.contractAll();
+
+    edges.resize(contractor.edges.size());
+    for (size_t i = 0; i < edges.size(); ++i)
+    {
+        const auto &r = contractor.edges[i];
+        edges[i] = {r.from, r.to, r.weight, r.childA, r.childB};
+    }
+    toCSR(upLists, upOffsets, upEdges);
+    toCSR(downLists, downOffsets, downEdges);
+    graphNodes = n;
+    graphEdgeCount = g.numEdges();
+    graphFingerprint = fingerprintOf(g);
+    graphProfile = g.profile();
+
+    auto t1 = std::chrono::steady_clock::now();
+    std::cout << "Built contraction hierarchy: " << numShortcuts() << " shortcuts in "
+              << std::chrono::duration<double, std::milli>(t1 - t0).count() << " ms\n";
+}
+
+bool ContractionHierarchy::matches(const Graph &g) const
+{
+    return graphProfile == g.profile() && graphNodes == g.numNodes() && graphEdgeCount == g.numEdges() &&
+           graphFingerprint == fingerprintOf(g);
+}
+
+int ContractionHierarchy::upEdge(int from, int to) const
+{
+    for (int i = upOffsets[from]; i < upOffsets[from + 1]; ++i)
+        if (edges[upEdges[i]].to == to)
+            return upEdges[i];
+    return -1;
+}
+
+int ContractionHierarchy::downEdge(int from, int to) const
+{
+    for (int i = downOffsets[to]; i < downOffsets[to + 1]; ++i)
+        if (edges[downEdges[i]].from == from)
+            return downEdges[i];
+    return -1;
+}
+
+void ContractionHierarchy::unpackEdge(int e, std::vector<int> &path) const
+{
+    std::vector<int> stack{e};
+    while (!stack.empty())
+    {
+        int cur = stack.back();
+        stack.pop_back();
+        const Edge &edge = edges[cur];
+        if (edge.childA == -1)
+        {
+            path.push_back(edge.to);
+            continue;
+        }
+        stack.push_back(edge.childB);
+        stack.push_back(edge.childA);
+    }
+}
+
+PathResult ContractionHierarchy::query(int src, int dest) const
+{
+    const int n = numNodes();
+    if (src < 0 || dest < 0 || src >= n || dest >= n)
+        throw std::out_of_range("ContractionHierarchy::query: node index out of range");
+    if (src == dest)
+        return {{src}, 0.0, 0};
+
+    SearchWorkspace &workspace = SearchWorkspace::local();
+    SearchSpace &fwd = workspace.forward;
+    SearchSpace &bwd = workspace.backward;
+    fwd.reset(n);
+    bwd.reset(n);
+    fwd.update(src, 0.0, 0.0, -1);
+    fwd.push(0.0, src);
+    bwd.update(dest, 0.0, 0.0, -1);
+    bwd.push(0.0, dest);
+
+    Distance mu = INF_DISTANCE;
+    int meet = -1;
+    size_t nodeVisited = 0;
+    bool forwardTurn = true;
+
+    // Each direction runs until its queue minimum reaches mu; the usual
+    // sum criterion does not hold on upward-only searches
+    for (;;)
+    {
+        bool fwdLive = !fwd.empty() && fwd.top().first < mu;
+        bool bwdLive = !bwd.empty() && bwd.top().first < mu;
+        if (!fwdLive && !bwdLive)
+            break;
+        bool forward = fwdLive && (forwardTurn || !bwdLive);
+        forwardTurn = !forwardTurn;
+
+        SearchSpace &space = forward ? fwd : bwd;
+        const SearchSpace &other = forward ? bwd : fwd;
+        auto [key, u] = space.pop();
+        if (key > space.key(u))
+            continue;
+        Distance d = space.dist(u);
+
+        if (other.reached(u) && d + other.dist(u) < mu)
+        {
+            mu = d + other.dist(u);
+            meet = u;
+        }
+
+        // Stall on demand: u is not on a shortest up-down path if a higher
+        // node already reaches it more cheaply through a downward edge
+        const std::vector<int> &stallOffsets = forward ? downOffsets : upOffsets;
+        const std::vector<int> &stallEdges = forward ? downEdges : upEdges;
+        bool stalled = false;
+        for (int i = stallOffsets[u]; i < stallOffsets[u + 1]; ++i)
+        {
+            const Edge &edge = edges[stallEdges[i]];
+            int x = forward ? edge.from : edge.to;
+            if (space.dist(x) + edge.weight < d)
+            {
+                stalled = true;
+                break;
+            }
+        }
+        if (stalled)
+            continue;
+
+        ++nodeVisited;
+
+        const std::vector<int> &offsets = forward ? upOffsets : downOffsets;
+        const std::vector<int> &ids = forward ? upEdges : downEdges;
+        for (int i = offsets[u]; i < offsets[u + 1]; ++i)
+        {
+            const Edge &edge = edges[ids[i]];
+            int v = forward ? edge.to : edge.from;
+            Distance nd = d + edge.weight;
+            if (nd < space.dist(v))
+            {
+                space.update(v, nd, nd, u);
+                space.push(nd, v);
+            }
+        }
+    }
+
+    if (meet == -1)
+        return {{}, 0.0, nodeVisited};
+
+    std::vector<int> upPath = fwd.pathTo(meet);
+    std::vector<int> path{src};
+    for (size_t i = 0; i + 1 < upPath.size(); ++i)
+        unpackEdge(upEdge(upPath[i], upPath[i + 1]), path);
+    for (int cur = meet, next = bwd.parent(meet); next != -1; cur = next, next = bwd.parent(next))
+        unpackEdge(downEdge(cur, next), path);
+
+    return {std::move(path), Graph::toCost(mu), nodeVisited};
+}
+
+void ContractionHierarchy::save(const std::string &filename) const
+{
+    std::ofstream out(filename, std::ios::binary | std::ios::trunc);
+    if (!out.is_open())
+        throw std::runtime_error("Cannot open hierarchy file for writing: " + filename);
+
+    out.write(CH_MAGIC, sizeof(CH_MAGIC));
+    uint32_t version = CH_VERSION;
+    double weightScale = WEIGHT_SCALE;
+    out.write(reinterpret_cast<const char *>(&version), sizeof(version));
+    out.write(reinterpret_cast<const char *>(&weightScale), sizeof(weightScale));
+    int64_t counts[3] = {graphNodes, graphEdgeCount, (int64_t)graphEdges};
+    out.write(reinterpret_cast<const char *>(counts), sizeof(counts));
+    out.write(reinterpret_cast<const char *>(&graphFingerprint), sizeof(graphFingerprint));
+    uint32_t profileId = (uint32_t)graphProfile;
+    out.write(reinterpret_cast<const char *>(&profileId), sizeof(profileId));
+    writeVector(out, rank);
+    writeVector(out, edges);
+    writeVector(out, upOffsets);
+    writeVector(out, upEdges);
+    writeVector(out, downOffsets);
+    writeVector(out, downEdges);
+
+    if (!out)
+        throw std::runtime_error("Failed writing hierarchy file: " + filename);
+}
+
+void ContractionHierarchy::load(const std::string &filename)
+{
+    std::ifstream in(filename, std::ios::binary);
+    if (!in.is_open())
+        throw std::runtime_error("Cannot open hierarchy file: " + filename);
+
+    char magic[sizeof(CH_MAGIC)];
+    uint32_t version = 0;
+    double weightScale = 0.0;
+    int64_t counts[3] = {};
+    uint64_t fingerprint = 0;
+    uint32_t profileId = 0;
+    in.read(magic, sizeof(magic));
+    in.read(reinterpret_cast<char *>(&version), sizeof(version));
+    if (!in || std::memcmp(magic, CH_MAGIC, sizeof(magic)) != 0)
+        throw std::runtime_error("Invalid hierarchy file: " + filename);
+    if (version != CH_VERSION)
+        throw std::runtime_error("Unsupported hierarchy version " + std::to_string(version));
+    in.read(reinterpret_cast<char *>(&weightScale), sizeof(weightScale));
+    in.read(reinterpret_cast<char *>(counts), sizeof(counts));
+    in.read(reinterpret_cast<char *>(&fingerprint), sizeof(fingerprint));
+    in.read(reinterpret_cast<char *>(&profileId), sizeof(profileId));
+    if (!in)
+        throw std::runtime_error("Invalid hierarchy file: truncated " + filename);
+    if (profileId >= (uint32_t)PROFILE_COUNT)
+        throw std::runtime_error("Invalid hierarchy file: unknown profile in " + filename);
+    if (weightScale != WEIGHT_SCALE)
+        throw std::runtime_error("Hierarchy was built with a different edge weight format: " + filename);
+
+    ContractionHierarchy loaded;
+    loaded.graphNodes = (int)counts[0];
+    loaded.graphEdgeCount = (int)counts[1];
+    loaded.graphEdges = (size_t)counts[2];
+    loaded.graphFingerprint = fingerprint;
+    loaded.graphProfile = (Profile)profileId;
+    readVector(in, loaded.rank);
+    readVector(in, loaded.edges);
+    readVector(in, loaded.upOffsets);
+    readVector(in, loaded.upEdges);
+    readVector(in, loaded.downOffsets);
+    readVector(in, loaded.downEdges);
+    if (!in)
+        throw std::runtime_error("Invalid hierarchy file: truncated " + filename);
+
+    const size_t n = loaded.rank.size();
+    if (loaded.upOffsets.size() != n + 1 || loaded.downOffsets.size() != n + 1 ||
+        (size_t)loaded.upOffsets.back() != loaded.upEdges.size() ||
+        (size_t)loaded.downOffsets.back() != loaded.downEdges.size())
+        throw std::runtime_error("Invalid hierarchy file: inconsistent offsets");
+    if (n != (size_t)loaded.graphNodes || loaded.graphEdges > loaded.edges.size())
+        throw std::runtime_error("Invalid hierarchy file: inconsistent counts");
+
+    // Queries index edges and unpack shortcuts without further checks, so
+    // every id must be in range and every shortcut must only refer to
+    // earlier edges, which also rules out cycles while unpacking
+    auto checkCSR = [&](const std::vector<int> &offsets, const std::vector<int> &ids)
+    {
+        if (offsets[0] != 0)
+            return false;
+        for (size_t i = 0; i < n; ++i)
+            if (offsets[i] > offsets[i + 1])
+                return false;
+        for (int id : ids)
+            if (id < 0 || (size_t)id >= loaded.edges.size())
+                return false;
+        return true;
+    };
+    if (!checkCSR(loaded.upOffsets, loaded.upEdges) || !checkCSR(loaded.downOffsets, loaded.downEdges))
+        throw std::runtime_error("Invalid hierarchy file: inconsistent offsets");
+    for (int r : loaded.rank)
+        if (r < 0 || (size_t)r >= n)
+            throw std::runtime_error("Invalid hierarchy file: rank out of range");
+    for (size_t i = 0; i < loaded.edges.size(); ++i)
+    {
+        const Edge &edge = loaded.edges[i];
+        bool original = i < loaded.graphEdges;
+        if (edge.from < 0 || (size_t)edge.from >= n || edge.to < 0 || (size_t)edge.to >= n ||
+            (original && (edge.childA != -1 || edge.childB != -1)) ||
+            (!original && (edge.childA < 0 || (size_t)edge.childA >= i ||
+                           edge.childB < 0 || (size_t)edge.childB >= i)))
+            throw std::runtime_error("Invalid hierarchy file: edge out of range");
+    }
+
+    *this = std::move(loaded);
+}
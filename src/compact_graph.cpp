@@ -0,0 +1,413 @@
+// compact_graph.cpp
+#include "compact_graph.hpp"
+#include "yen.hpp"
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <stdexcept>
+
+namespace
+{
+
+// Segment of the compact graph in full-graph ids: a chain, or (chain -1)
+// the full graph's edge from -> to and its opposite half
+struct Link
+{
+    int from;
+    int to;
+    int forwardEdge;
+    int backwardEdge;
+    int chain;
+};
+
+// Opposite half of edge e out of u: the k-th v -> u half for the k-th
+// u -> v one. Parallel halves may pair up differently from how they were
+// added, which leaves the same directed edges.
+int twinEdge(const Graph &g, int u, int e)
+{
+    int v = g.edgeTarget(e);
+    int k = 0;
+    for (int f = g.edgeBegin(u); f < e; ++f)
+        k += g.edgeTarget(f) == v;
+    for (int f = g.edgeBegin(v); f < g.edgeEnd(v); ++f)
+        if (g.edgeTarget(f) == u && k-- == 0)
+            return f;
+    return -1;
+}
+
+} // namespace
+
+void CompactGraph::build(const Graph &g)
+{
+    auto t0 = std::chrono::steady_clock::now();
+    const int n = g.numNodes();
+    auto t = std::make_shared<Topology>();
+    topo = t;
+
+    // A chain node has exactly two edge halves, to two other distinct nodes
+    std::vector<char> junction(n, 1);
+    for (int u = 0; u < n; ++u)
+    {
+        if (g.edgeEnd(u) - g.edgeBegin(u) != 2)
+            continue;
+        int a = g.edgeTarget(g.edgeBegin(u));
+        int b = g.edgeTarget(g.edgeBegin(u) + 1);
+        junction[u] = a == b || a == u || b == u;
+    }
+
+    // Walk the chains out of every junction. Loops, rings without any
+    // junction and segments parallel to another one promote chain nodes to
+    // junctions and the walk runs again; the second pass finds none.
+    std::vector<Link> links;
+    std::vector<char> claimed(n);
+    for (bool promoted = true; promoted;)
+    {
+        promoted = false;
+        links.clear();
+        t->chains.clear();
+        t->interior.clear();
+        t->hopEdge.clear();
+        t->hopBackEdge.clear();
+        std::fill(claimed.begin(), claimed.end(), 0);
+
+        for (int a = 0; a < n; ++a)
+        {
+            if (!junction[a])
+                continue;
+            for (int e = g.edgeBegin(a); e < g.edgeEnd(a); ++e)
+            {
+                int v = g.edgeTarget(e);
+                if (junction[v])
+                {
+                    // Each segment once, from its lower end; self-loops never lie on a route
+                    if (a < v)
+                        links.push_back({a, v, e, twinEdge(g, a, e), -1});
+                    continue;
+                }
+                if (claimed[v])
+                    continue;
+
+                // A chain node's halves go to two distinct nodes, so every
+                // hop's opposite half is the only edge back
+                Chain chain{a, -1, (int)t->interior.size(), 0, -1, -1};
+                int prev = a;
+                int cur = v;
+                int in = e;
+                while (!junction[cur])
+                {
+                    claimed[cur] = 1;
+                    t->interior.push_back(cur);
+                    t->hopEdge.push_back(in);
+                    t->hopBackEdge.push_back(g.findEdge(cur, prev));
+                    in = g.edgeBegin(cur);
+                    if (g.edgeTarget(in) == prev)
+                        ++in;
+                    prev = cur;
+                    cur = g.edgeTarget(in);
+                }
+                chain.to = cur;
+                chain.end = (int)t->interior.size();
+                chain.lastEdge = in;
+                chain.lastBackEdge = g.findEdge(cur, prev);
+                links.push_back({a, cur, -1, -1, (int)t->chains.size()});
+                t->chains.push_back(chain);
+            }
+        }
+
+        // Rings of chain nodes only: the lowest id becomes a junction, the
+        // rest of the ring its loop
+        for (int u = 0; u < n; ++u)
+        {
+            if (junction[u] || claimed[u])
+                continue;
+            junction[u] = 1;
+            promoted = true;
+            for (int prev = u, cur = g.edgeTarget(g.edgeBegin(u)); cur != u;)
+            {
+                claimed[cur] = 1;
+                int next = g.edgeBegin(cur);
+                if (g.edgeTarget(next) == prev)
+                    ++next;
+                prev = cur;
+                cur = g.edgeTarget(next);
+            }
+        }
+
+        std::unordered_map<uint64_t, int> perPair;
+        for (const Link &l : links)
+            ++perPair[pairKey(l.from, l.to)];
+        for (const Chain &c : t->chains)
+        {
+            if (c.from == c.to)
+            {
+                // A loop keeps its first and last node, leaving a triangle
+                junction[t->interior[c.begin]] = 1;
+                junction[t->interior[c.end - 1]] = 1;
+                promoted = true;
+            }
+            else if (perPair[pairKey(c.from, c.to)] > 1)
+            {
+                junction[t->interior[c.begin]] = 1;
+                promoted = true;
+            }
+        }
+    }
+
+    t->toCompact.assign(n, -1);
+    t->toFull.clear();
+    for (int u = 0; u < n; ++u)
+    {
+        if (!junction[u])
+            continue;
+        t->toCompact[u] = (int)t->toFull.size();
+        t->toFull.push_back(u);
+    }
+
+    readHops(g);
+
+    // Junctions keep the full graph's relative order, so its Hilbert
+    // numbering carries over
+    Graph &junctions = t->junctions;
+    for (int u : t->toFull)
+        junctions.getNodeIndex(g.nodes[u].lat, g.nodes[u].lon);
+    for (const Link &l : links)
+    {
+        const Chain *chain = l.chain == -1 ? nullptr : &t->chains[l.chain];
+        junctions.addSegment(t->toCompact[l.from], t->toCompact[l.to],
+                             chain ? hopSum(l.chain, chain->begin, chain->end, true) : g.edgeWeight(l.forwardEdge),
+                             chain ? hopSum(l.chain, chain->begin, chain->end, false) : g.edgeWeight(l.backwardEdge));
+    }
+    junctions.finalize(NodeOrder::Input);
+
+    t->slot.assign(n, -1);
+    t->interiorChain.assign(t->interior.size(), -1);
+    for (int c = 0; c < (int)t->chains.size(); ++c)
+    {
+        Chain &chain = t->chains[c];
+        chain.from = t->toCompact[chain.from];
+        chain.to = t->toCompact[chain.to];
+        t->chainByEnds[pairKey(chain.from, chain.to)] = c;
+        for (int i = chain.begin; i < chain.end; ++i)
+        {
+            t->slot[t->interior[i]] = i;
+            t->interiorChain[i] = c;
+        }
+    }
+
+    // Remember where each compact edge's weight comes from. A pair of
+    // junctions joined by a chain has no other segment; the k-th of several
+    // parallel u -> v segments copies the k-th full-graph u -> v edge, which
+    // may pair them up differently from how they were added but leaves the
+    // same directed edges.
+    t->edgeChain.assign(junctions.numEdges(), -1);
+    t->edgeFull.assign(junctions.numEdges(), -1);
+    for (int cu = 0; cu < junctions.numNodes(); ++cu)
+    {
+        for (int e = junctions.edgeBegin(cu); e < junctions.edgeEnd(cu); ++e)
+        {
+            int cv = junctions.edgeTarget(e);
+            auto it = t->chainByEnds.find(pairKey(cu, cv));
+            if (it != t->chainByEnds.end())
+            {
+                t->edgeChain[e] = it->second;
+                continue;
+            }
+            int k = 0;
+            for (int f = junctions.edgeBegin(cu); f < e; ++f)
+                k += junctions.edgeTarget(f) == cv;
+            int u = t->toFull[cu];
+            int v = t->toFull[cv];
+            for (int f = g.edgeBegin(u); f < g.edgeEnd(u); ++f)
+            {
+                if (g.edgeTarget(f) == v && k-- == 0)
+                {
+                    t->edgeFull[e] = f;
+                    break;
+                }
+            }
+        }
+    }
+
+    t->graphNodes = n;
+    t->graphEdgeCount = g.numEdges();
+    compact = junctions.withWeights(g.profile(), {});
+
+    double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+    std::cout << "Compacted graph: " << n << " -> " << compact.numNodes() << " nodes, "
+              << g.numEdges() << " -> " << compact.numEdges() << " edges in " << ms << " ms\n";
+}
+
+CompactGraph CompactGraph::withProfile(const Graph &view) const
+{
+    if (empty() || !matches(view))
+        throw std::runtime_error("CompactGraph::withProfile: view of a different graph");
+
+    CompactGraph c;
+    c.topo = topo;
+    c.readHops(view);
+    const Graph &junctions = topo->junctions;
+    std::vector<EdgeWeight> weights(junctions.numEdges());
+    for (int u = 0; u < junctions.numNodes(); ++u)
+    {
+        for (int e = junctions.edgeBegin(u); e < junctions.edgeEnd(u); ++e)
+        {
+            int chain = topo->edgeChain[e];
+            if (chain == -1)
+            {
+                weights[e] = view.edgeWeight(topo->edgeFull[e]);
+                continue;
+            }
+            const Chain &ch = topo->chains[chain];
+            weights[e] = c.hopSum(chain, ch.begin, ch.end, ch.from == u);
+        }
+    }
+    c.compact = junctions.withWeights(view.profile(), std::move(weights));
+    return c;
+}
+
+void CompactGraph::readHops(const Graph &g)
+{
+    hopForward.resize(topo->hopEdge.size());
+    hopBackward.resize(topo->hopBackEdge.size());
+    for (size_t i = 0; i < hopForward.size(); ++i)
+    {
+        hopForward[i] = g.edgeWeight(topo->hopEdge[i]);
+        hopBackward[i] = g.edgeWeight(topo->hopBackEdge[i]);
+    }
+    lastForward.resize(topo->chains.size());
+    lastBackward.resize(topo->chains.size());
+    for (size_t c = 0; c < lastForward.size(); ++c)
+    {
+        lastForward[c] = g.edgeWeight(topo->chains[c].lastEdge);
+        lastBackward[c] = g.edgeWeight(topo->chains[c].lastBackEdge);
+    }
+}
+
+EdgeWeight CompactGraph::hopSum(int c, int first, int last, bool forward) const
+{
+    const int end = topo->chains[c].end;
+    Distance sum = 0;
+    for (int h = first; h <= last; ++h)
+    {
+        EdgeWeight w = h == end ? (forward ? lastForward[c] : lastBackward[c])
+                                : (forward ? hopForward[h] : hopBackward[h]);
+        if (!isPassable(w))
+            return INF_WEIGHT;
+        sum += w;
+    }
+    return (EdgeWeight)sum;
+}
+
+bool CompactGraph::matches(const Graph &g) const
+{
+    return topo && topo->graphNodes == g.numNodes() && topo->graphEdgeCount == g.numEdges();
+}
+
+CompactQuery CompactGraph::prepare(const Graph &full, int src, int dest) const
+{
+    CompactQuery q;
+    q.owner = this;
+    q.base = &compact;
+
+    // Endpoints inside chains, in chain order so points sharing a chain are adjacent
+    const Topology &t = *topo;
+    std::vector<int> points;
+    for (int u : {src, dest})
+        if (t.slot[u] != -1 && std::find(points.begin(), points.end(), u) == points.end())
+            points.push_back(u);
+    std::sort(points.begin(), points.end(), [&](int a, int b)
+              { return t.slot[a] < t.slot[b]; });
+
+    const int n = compact.numNodes();
+    auto queryNode = [&](int u)
+    {
+        if (t.slot[u] == -1)
+            return t.toCompact[u];
+        return n + (int)(std::find(points.begin(), points.end(), u) - points.begin());
+    };
+    q.srcNode = queryNode(src);
+    q.destNode = queryNode(dest);
+    if (points.empty())
+        return q;
+
+    // Replace each affected chain by its pieces between consecutive split points
+    std::vector<Node> extra;
+    std::vector<int> removed;
+    std::vector<Graph::Segment> added;
+    for (size_t i = 0; i < points.size();)
+    {
+        const int c = t.interiorChain[t.slot[points[i]]];
+        const Chain &chain = t.chains[c];
+        removed.push_back(compact.findEdge(chain.from, chain.to));
+        removed.push_back(compact.findEdge(chain.to, chain.from));
+
+        int prev = chain.from;
+        int prevBegin = chain.begin;
+        for (; i < points.size() && t.interiorChain[t.slot[points[i]]] == c; ++i)
+        {
+            int s = t.slot[points[i]];
+            int x = n + (int)i;
+            extra.push_back(full.nodes[points[i]]);
+            q.extraFull.push_back(points[i]);
+            added.push_back({prev, x, hopSum(c, prevBegin, s, true), hopSum(c, prevBegin, s, false)});
+            q.pieces.push_back({prev, x, prevBegin, s});
+            prev = x;
+            prevBegin = s + 1;
+        }
+        added.push_back({prev, chain.to, hopSum(c, prevBegin, chain.end, true),
+                         hopSum(c, prevBegin, chain.end, false)});
+        q.pieces.push_back({prev, chain.to, prevBegin, chain.end});
+    }
+
+    q.overlay = compact.edited(extra, removed, added);
+    q.split = true;
+    return q;
+}
+
+int CompactQuery::fullNode(int x) const
+{
+    int n = base->numNodes();
+    return x < n ? owner->topo->toFull[x] : extraFull[x - n];
+}
+
+void CompactQuery::unpack(const Graph &full, PathResult &route) const
+{
+    if (route.path.empty())
+        return;
+
+    const CompactGraph::Topology &t = *owner->topo;
+    std::vector<int> path{fullNode(route.path[0])};
+    auto append = [&](int begin, int end, bool forward)
+    {
+        if (forward)
+            path.insert(path.end(), t.interior.begin() + begin, t.interior.begin() + end);
+        else
+            path.insert(path.end(), t.interior.rbegin() + (t.interior.size() - end),
+                        t.interior.rbegin() + (t.interior.size() - begin));
+    };
+
+    for (size_t i = 1; i < route.path.size(); ++i)
+    {
+        int a = route.path[i - 1];
+        int b = route.path[i];
+        auto piece = std::find_if(pieces.begin(), pieces.end(), [&](const Piece &p)
+                                  { return (p.from == a && p.to == b) || (p.from == b && p.to == a); });
+        if (piece != pieces.end())
+        {
+            append(piece->begin, piece->end, piece->from == a);
+        }
+        else
+        {
+            auto it = t.chainByEnds.find(CompactGraph::pairKey(a, b));
+            if (it != t.chainByEnds.end())
+            {
+                const CompactGraph::Chain &chain = t.chains[it->second];
+                append(chain.begin, chain.end, chain.from == a);
+            }
+        }
+        path.push_back(fullNode(b));
+    }
+
+    route.path = std::move(path);
+    route.length = yen_detail::pathLength(full, route.path);
+}
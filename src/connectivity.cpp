@@ -0,0 +1,1155 @@
+// connectivity.cpp
+#include "connectivity.hpp"
+#include "thread_pool.hpp"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+
+static size_t getCurrentRSSKB()
+{
+    std::ifstream file("/proc/self/status");
+    std::string line;
+    while (std::getline(file, line))
+    {
+        if (line.find("VmRSS:") == 0)
+        {
+            std::istringstream iss(line);
+            std::string key;
+            size_t value;
+            std::string unit;
+            iss >> key >> value >> unit;
+            return value; // VmRSS in KB
+        }
+    }
+    return 0;
+}
+
+namespace
+{
+
+// Low-link arrays shared by every DFS of a forest. Concurrent walks touch
+// disjoint components, so they may share them.
+struct TarjanArrays
+{
+    explicit TarjanArrays(int n) : disc(n, 0), low(n, 0), isArt(n, 0) {}
+
+    std::vector<int> disc;
+    std::vector<int> low;
+    std::vector<char> isArt;
+    std::vector<int> edgeComponent;  // sized only when components are requested
+};
+
+// Per-walker DFS state; the frame and edge stacks keep their memory from one
+// tree to the next. Discovery times only need to be ordered within a tree.
+struct TarjanWalker
+{
+    struct Frame
+    {
+        int u;
+        int parent;      // -1 at the root
+        int treeEdge;    // parent -> u, -1 at the root
+        int edge;        // next edge of u to scan
+        bool skippedParent;
+    };
+
+    std::vector<Frame> frames;
+    std::vector<int> edgeStack;
+    std::vector<int> bridges;
+    int time = 0;
+    int numComponents = 0;
+};
+
+// The half of segment tail -> head (edge e) that leaves the lower node id,
+// so a bridge is reported the same way whichever direction found it
+int lowerHalf(const Graph &g, int tail, int head, int e)
+{
+    if (tail < head)
+        return e;
+    for (int r = g.edgeBegin(head); r < g.edgeEnd(head); ++r)
+        if (g.edgeTarget(r) == tail)
+            return r;
+    return e;
+}
+
+// Iterative DFS from root. A child's frame is pushed before its parent's
+// scan resumes, so a frame is only finished once its last edge is scanned
+// and nothing was pushed on top of it. Only one edge back to the parent is
+// skipped, so a parallel segment counts as a back edge.
+template <bool Components>
+void dfsBiconnected(int root, const Graph &g, TarjanArrays &s, TarjanWalker &w)
+{
+    auto &frames = w.frames;
+    frames.clear();
+    s.disc[root] = s.low[root] = ++w.time;
+    frames.push_back({root, -1, -1, g.edgeBegin(root), false});
+    int rootChildren = 0;
+
+    while (!frames.empty())
+    {
+        TarjanWalker::Frame &frame = frames.back();
+        const int u = frame.u;
+        bool descended = false;
+
+        for (const int end = g.edgeEnd(u); frame.edge < end;)
+        {
+            int e = frame.edge++;
+            int v = g.edgeTarget(e);
+            if (v == frame.parent && !frame.skippedParent)
+            {
+                frame.skippedParent = true;
+                continue;
+            }
+
+            if (s.disc[v] == 0)
+            {
+                if (frame.parent == -1)
+                    ++rootChildren;
+                if constexpr (Components)
+                    w.edgeStack.push_back(e);
+                s.disc[v] = s.low[v] = ++w.time;
+                frames.push_back({v, u, e, g.edgeBegin(v), false});
+                descended = true;
+                break;
+            }
+            if (s.disc[v] < s.disc[u])
+            {
+                // Back edge to an ancestor; the ancestor sees it as a forward edge
+                s.low[u] = std::min(s.low[u], s.disc[v]);
+                if constexpr (Components)
+                    w.edgeStack.push_back(e);
+            }
+        }
+        if (descended)
+            continue;
+
+        const TarjanWalker::Frame done = frame;
+        frames.pop_back();
+        if (done.parent == -1)
+        {
+            if (rootChildren > 1)
+                s.isArt[u] = 1;
+            continue;
+        }
+
+        const int p = done.parent;
+        s.low[p] = std::min(s.low[p], s.low[u]);
+        if (s.low[u] >= s.disc[p])
+        {
+            // The root is only a cut node with two or more DFS children
+            if (p != root)
+                s.isArt[p] = 1;
+            if constexpr (Components)
+            {
+                // Everything above the tree edge p -> u forms one block
+                int e;
+                do
+                {
+                    e = w.edgeStack.back();
+                    w.edgeStack.pop_back();
+                    s.edgeComponent[e] = w.numComponents;
+                } while (e != done.treeEdge);
+                ++w.numComponents;
+            }
+        }
+        if (s.low[u] > s.disc[p])
+            w.bridges.push_back(lowerHalf(g, p, u, done.treeEdge));
+    }
+}
+
+// Run the DFS over every tree of the forest; returns the number of trees
+template <bool Components>
+int runForest(const Graph &g, TarjanArrays &s, TarjanWalker &w)
+{
+    const int n = g.numNodes();
+    int trees = 0;
+    for (int i = 0; i < n; ++i)
+    {
+        if (s.disc[i] == 0)
+        {
+            dfsBiconnected<Components>(i, g, s, w);
+            ++trees;
+        }
+    }
+    return trees;
+}
+
+// ---- Parallel pipeline ---------------------------------------------------
+
+// Nodes per task in the parallel loops below
+constexpr size_t CHUNK = 2048;
+
+// fn(chunk, begin, end) over [0, count) in CHUNK-sized pieces
+template <typename Fn>
+void parallelChunks(size_t count, unsigned threads, Fn &&fn)
+{
+    const size_t chunks = (count + CHUNK - 1) / CHUNK;
+    ThreadPool::shared().parallelFor(chunks, [&](size_t c)
+                                     { fn(c, c * CHUNK, std::min(count, (c + 1) * CHUNK)); },
+                                     threads);
+}
+
+void atomicMin(std::atomic<int> &slot, int value)
+{
+    int cur = slot.load(std::memory_order_relaxed);
+    while (value < cur && !slot.compare_exchange_weak(cur, value, std::memory_order_relaxed))
+    {
+    }
+}
+
+void atomicMax(std::atomic<int> &slot, int value)
+{
+    int cur = slot.load(std::memory_order_relaxed);
+    while (value > cur && !slot.compare_exchange_weak(cur, value, std::memory_order_relaxed))
+    {
+    }
+}
+
+// Lock-free union-find. Roots always link to the smaller id, so each set's
+// root is its smallest node, and finds halve paths as they go.
+class ConcurrentUnionFind
+{
+public:
+    ConcurrentUnionFind(int n, unsigned threads) : parent(n)
+    {
+        parallelChunks(n, threads, [&](size_t, size_t begin, size_t end)
+                       {
+            for (size_t i = begin; i < end; ++i)
+                parent[i].store((int)i, std::memory_order_relaxed); });
+    }
+
+    int find(int x)
+    {
+        for (;;)
+        {
+            int p = parent[x].load(std::memory_order_relaxed);
+            if (p == x)
+                return x;
+            int gp = parent[p].load(std::memory_order_relaxed);
+            if (gp != p)
+                parent[x].compare_exchange_weak(p, gp, std::memory_order_relaxed);
+            x = gp;
+        }
+    }
+
+    void unite(int a, int b)
+    {
+        for (;;)
+        {
+            a = find(a);
+            b = find(b);
+            if (a == b)
+                return;
+            if (a < b)
+                std::swap(a, b);
+            int expected = a;
+            if (parent[a].compare_exchange_strong(expected, b))
+                return;
+        }
+    }
+
+private:
+    std::vector<std::atomic<int>> parent;
+};
+
+// Tarjan-Vishkin over the given connected components, each named by its
+// smallest node. A level-synchronous BFS builds spanning trees; subtree
+// sizes, preorder numbers and the low/high preorder reachable from each
+// subtree follow level by level. Tree edges (named by their child) then
+// merge into blocks through a second union-find:
+//   - a non-tree edge between unrelated nodes joins their two tree edges
+//   - tree edge v -> w joins v's own when w's subtree reaches outside v's
+// A node is a cut node when its tree edges lie in two or more blocks, and
+// tree edge p -> w is a bridge when no other edge leaves w's subtree.
+void tarjanVishkin(const Graph &g, const std::vector<int> &roots, unsigned threads,
+                   std::vector<char> &isArt, std::vector<int> &bridges)
+{
+    const int n = g.numNodes();
+    std::vector<std::atomic<int>> parent(n);
+    std::vector<int> treeEdge(n, -1);
+    parallelChunks(n, threads, [&](size_t, size_t begin, size_t end)
+                   {
+        for (size_t i = begin; i < end; ++i)
+            parent[i].store(-1, std::memory_order_relaxed); });
+
+    // BFS levels; roots are their own parent
+    std::vector<std::vector<int>> levels{roots};
+    for (int r : roots)
+        parent[r].store(r, std::memory_order_relaxed);
+    for (;;)
+    {
+        const std::vector<int> &frontier = levels.back();
+        std::vector<std::vector<int>> found((frontier.size() + CHUNK - 1) / CHUNK);
+        parallelChunks(frontier.size(), threads, [&](size_t c, size_t begin, size_t end)
+                       {
+            for (size_t i = begin; i < end; ++i)
+            {
+                int u = frontier[i];
+                for (int e = g.edgeBegin(u); e < g.edgeEnd(u); ++e)
+                {
+                    int v = g.edgeTarget(e);
+                    int expected = -1;
+                    if (parent[v].load(std::memory_order_relaxed) == -1 &&
+                        parent[v].compare_exchange_strong(expected, u))
+                    {
+                        treeEdge[v] = e;
+                        found[c].push_back(v);
+                    }
+                }
+            } });
+        std::vector<int> next;
+        for (auto &part : found)
+            next.insert(next.end(), part.begin(), part.end());
+        if (next.empty())
+            break;
+        levels.push_back(std::move(next));
+    }
+    auto parentOf = [&](int v)
+    { return parent[v].load(std::memory_order_relaxed); };
+
+    // Subtree sizes, deepest level first
+    std::vector<std::atomic<int>> size(n);
+    for (const auto &level : levels)
+        for (int v : level)
+            size[v].store(1, std::memory_order_relaxed);
+    for (size_t l = levels.size() - 1; l > 0; --l)
+    {
+        const std::vector<int> &level = levels[l];
+        parallelChunks(level.size(), threads, [&](size_t, size_t begin, size_t end)
+                       {
+            for (size_t i = begin; i < end; ++i)
+                size[parentOf(level[i])].fetch_add(size[level[i]].load(std::memory_order_relaxed),
+                                                   std::memory_order_relaxed); });
+    }
+    auto nd = [&](int v)
+    { return size[v].load(std::memory_order_relaxed); };
+
+    // Preorder numbers, children in edge order
+    std::vector<int> pre(n, 0);
+    int offset = 0;
+    for (int r : roots)
+    {
+        pre[r] = offset;
+        offset += nd(r);
+    }
+    for (const auto &level : levels)
+    {
+        parallelChunks(level.size(), threads, [&](size_t, size_t begin, size_t end)
+                       {
+            for (size_t i = begin; i < end; ++i)
+            {
+                int u = level[i];
+                int next = pre[u] + 1;
+                for (int e = g.edgeBegin(u); e < g.edgeEnd(u); ++e)
+                {
+                    int v = g.edgeTarget(e);
+                    if (treeEdge[v] == e)
+                    {
+                        pre[v] = next;
+                        next += nd(v);
+                    }
+                }
+            } });
+    }
+
+    // Lowest and highest preorder reachable from each subtree by one edge
+    // other than the tree edge to the subtree's parent (skipped once)
+    std::vector<std::atomic<int>> low(n), high(n);
+    for (const auto &level : levels)
+    {
+        parallelChunks(level.size(), threads, [&](size_t, size_t begin, size_t end)
+                       {
+            for (size_t i = begin; i < end; ++i)
+            {
+                int v = level[i];
+                int p = parentOf(v);
+                bool skipped = p == v;
+                int lo = pre[v], hi = pre[v];
+                for (int e = g.edgeBegin(v); e < g.edgeEnd(v); ++e)
+                {
+                    int w = g.edgeTarget(e);
+                    if (w == p && !skipped)
+                    {
+                        skipped = true;
+                        continue;
+                    }
+                    lo = std::min(lo, pre[w]);
+                    hi = std::max(hi, pre[w]);
+                }
+                low[v].store(lo, std::memory_order_relaxed);
+                high[v].store(hi, std::memory_order_relaxed);
+            } });
+    }
+    for (size_t l = levels.size() - 1; l > 0; --l)
+    {
+        const std::vector<int> &level = levels[l];
+        parallelChunks(level.size(), threads, [&](size_t, size_t begin, size_t end)
+                       {
+            for (size_t i = begin; i < end; ++i)
+            {
+                int v = level[i];
+                atomicMin(low[parentOf(v)], low[v].load(std::memory_order_relaxed));
+                atomicMax(high[parentOf(v)], high[v].load(std::memory_order_relaxed));
+            } });
+    }
+    auto outside = [&](int w, int v)
+    {
+        return low[w].load(std::memory_order_relaxed) < pre[v] ||
+               high[w].load(std::memory_order_relaxed) >= pre[v] + nd(v);
+    };
+
+    // Blocks of tree edges, each named by its child node
+    ConcurrentUnionFind blocks(n, threads);
+    for (size_t l = 1; l < levels.size(); ++l)
+    {
+        const std::vector<int> &level = levels[l];
+        parallelChunks(level.size(), threads, [&](size_t, size_t begin, size_t end)
+                       {
+            for (size_t i = begin; i < end; ++i)
+            {
+                int x = level[i];
+                for (int e = g.edgeBegin(x); e < g.edgeEnd(x); ++e)
+                {
+                    int y = g.edgeTarget(e);
+                    if (pre[x] < pre[y] && pre[y] >= pre[x] + nd(x))
+                        blocks.unite(x, y);
+                }
+                int v = parentOf(x);
+                if (parentOf(v) != v && outside(x, v))
+                    blocks.unite(x, v);
+            } });
+    }
+
+    for (size_t l = 0; l < levels.size(); ++l)
+    {
+        const std::vector<int> &level = levels[l];
+        parallelChunks(level.size(), threads, [&](size_t, size_t begin, size_t end)
+                       {
+            for (size_t i = begin; i < end; ++i)
+            {
+                int v = level[i];
+                int first = parentOf(v) != v ? blocks.find(v) : -1;
+                for (int e = g.edgeBegin(v); e < g.edgeEnd(v); ++e)
+                {
+                    int c = g.edgeTarget(e);
+                    if (treeEdge[c] != e)
+                        continue;
+                    int b = blocks.find(c);
+                    if (first == -1)
+                        first = b;
+                    else if (b != first)
+                    {
+                        isArt[v] = 1;
+                        break;
+                    }
+                }
+            } });
+    }
+
+    for (size_t l = 1; l < levels.size(); ++l)
+    {
+        const std::vector<int> &level = levels[l];
+        std::vector<std::vector<int>> parts((level.size() + CHUNK - 1) / CHUNK);
+        parallelChunks(level.size(), threads, [&](size_t c, size_t begin, size_t end)
+                       {
+            for (size_t i = begin; i < end; ++i)
+            {
+                int w = level[i];
+                if (!outside(w, w))
+                    parts[c].push_back(lowerHalf(g, parentOf(w), w, treeEdge[w]));
+            } });
+        for (auto &part : parts)
+            bridges.insert(bridges.end(), part.begin(), part.end());
+    }
+}
+
+// Serial DFS, or the parallel pipeline: a concurrent union-find finds the
+// connected components, small ones get one DFS each on the shared pool and
+// any component above a fair share of the nodes goes through Tarjan-Vishkin
+CriticalElements criticalElements(const Graph &g, int threads)
+{
+    const int n = g.numNodes();
+    CriticalElements result;
+    unsigned workers = threads > 0 ? (unsigned)threads : ThreadPool::shared().size() + 1;
+
+    if (workers <= 1)
+    {
+        TarjanArrays arrays(n);
+        TarjanWalker walker;
+        result.connectedComponents = runForest<false>(g, arrays, walker);
+        for (int i = 0; i < n; ++i)
+            if (arrays.isArt[i])
+                result.articulationPoints.push_back(i);
+        result.bridges = std::move(walker.bridges);
+        std::sort(result.bridges.begin(), result.bridges.end());
+        return result;
+    }
+
+    ConcurrentUnionFind components(n, workers);
+    parallelChunks(n, workers, [&](size_t, size_t begin, size_t end)
+                   {
+        for (size_t u = begin; u < end; ++u)
+            for (int e = g.edgeBegin((int)u); e < g.edgeEnd((int)u); ++e)
+                if ((int)u < g.edgeTarget(e))
+                    components.unite((int)u, g.edgeTarget(e)); });
+
+    std::vector<std::atomic<int>> componentSize(n);
+    parallelChunks(n, workers, [&](size_t, size_t begin, size_t end)
+                   {
+        for (size_t u = begin; u < end; ++u)
+            componentSize[components.find((int)u)].fetch_add(1, std::memory_order_relaxed); });
+
+    const int largeSize = n / (4 * (int)workers) + 1;
+    std::vector<int> smallRoots, largeRoots;
+    for (int u = 0; u < n; ++u)
+    {
+        int size = componentSize[u].load(std::memory_order_relaxed);
+        if (size == 0)
+            continue;
+        ++result.connectedComponents;
+        if (size == 1)
+            continue;
+        (size >= largeSize ? largeRoots : smallRoots).push_back(u);
+    }
+
+    TarjanArrays arrays(n);
+    const size_t smallChunks = (smallRoots.size() + CHUNK - 1) / CHUNK;
+    std::vector<TarjanWalker> walkers(smallChunks);
+    parallelChunks(smallRoots.size(), workers, [&](size_t c, size_t begin, size_t end)
+                   {
+        for (size_t i = begin; i < end; ++i)
+            dfsBiconnected<false>(smallRoots[i], g, arrays, walkers[c]); });
+
+    std::vector<int> bridges;
+    if (!largeRoots.empty())
+        tarjanVishkin(g, largeRoots, workers, arrays.isArt, bridges);
+    for (auto &walker : walkers)
+        bridges.insert(bridges.end(), walker.bridges.begin(), walker.bridges.end());
+
+    for (int i = 0; i < n; ++i)
+        if (arrays.isArt[i])
+            result.articulationPoints.push_back(i);
+    std::sort(bridges.begin(), bridges.end());
+    result.bridges = std::move(bridges);
+    return result;
+}
+
+} // namespace
+
+PathResult findCriticalPoints(const Graph &g, int threads)
+{
+    CriticalElements elements = findCriticalElements(g, threads);
+
+    PathResult result;
+    result.path = std::move(elements.articulationPoints);
+    result.timeMS = elements.timeMS;
+    result.memoryUsage = elements.memoryUsage;
+    return result;
+}
+
+CriticalElements findCriticalElements(const Graph &g, int threads)
+{
+    if (g.numNodes() == 0)
+        throw std::runtime_error("Graph is empty");
+
+    auto t0 = std::chrono::steady_clock::now();
+    size_t memBefore = getCurrentRSSKB();
+
+    CriticalElements result = criticalElements(g, threads);
+
+    auto t1 = std::chrono::steady_clock::now();
+    size_t memAfter = getCurrentRSSKB();
+
+    result.timeMS = std::chrono::duration<double, std::milli>(t1 - t0).count();
+    result.memoryUsage = memAfter - memBefore;
+    return result;
+}
+
+BiconnectivityResult findBiconnectedComponents(const Graph &g)
+{
+    int n = g.numNodes();
+    if (n == 0)
+        throw std::runtime_error("Graph is empty");
+
+    auto t0 = std::chrono::steady_clock::now();
+    size_t memBefore = getCurrentRSSKB();
+
+    TarjanArrays state(n);
+    TarjanWalker walker;
+    state.edgeComponent.assign(g.numEdges(), -1);
+    runForest<true>(g, state, walker);
+
+    BiconnectivityResult result;
+    result.numComponents = walker.numComponents;
+
+    // The DFS labels one half of each segment; the other half is any
+    // labelled edge running the opposite way (parallel halves share a block)
+    std::vector<int> &component = state.edgeComponent;
+    for (int u = 0; u < n; ++u)
+    {
+        for (int e = g.edgeBegin(u); e < g.edgeEnd(u); ++e)
+        {
+            int v = g.edgeTarget(e);
+            if (component[e] != -1 || v == u)
+                continue;
+            for (int r = g.edgeBegin(v); r < g.edgeEnd(v); ++r)
+            {
+                if (g.edgeTarget(r) == u && component[r] != -1)
+                {
+                    component[e] = component[r];
+                    break;
+                }
+            }
+        }
+    }
+
+    for (int i = 0; i < n; ++i)
+        if (state.isArt[i])
+            result.articulationPoints.push_back(i);
+
+    for (int u = 0; u < n; ++u)
+    {
+        if (!state.isArt[u])
+            continue;
+        for (int e = g.edgeBegin(u); e < g.edgeEnd(u); ++e)
+            if (component[e] != -1)
+                result.blockCutEdges.emplace_back(component[e], u);
+    }
+    std::sort(result.blockCutEdges.begin(), result.blockCutEdges.end());
+    result.blockCutEdges.erase(std::unique(result.blockCutEdges.begin(), result.blockCutEdges.end()),
+                               result.blockCutEdges.end());
+
+    result.bridges = std::move(walker.bridges);
+    std::sort(result.bridges.begin(), result.bridges.end());
+    result.edgeComponent = std::move(component);
+
+    auto t1 = std::chrono::steady_clock::now();
+    size_t memAfter = getCurrentRSSKB();
+
+    result.timeMS = std::chrono::duration<double, std::milli>(t1 - t0).count();
+    result.memoryUsage = memAfter - memBefore;
+    return result;
+}
+
+// ---- DynamicCriticalPoints -------------------------------------------------
+
+DynamicCriticalPoints::DynamicCriticalPoints(const Graph &g)
+    : g(g), twin(g.numEdges(), -1), closed(g.numEdges(), 0), isArt(g.numNodes(), 0),
+      stamp(g.numNodes(), 0), link(g.numNodes()), side(g.numNodes()), pathIndex(g.numNodes()),
+      clusterMin(g.numNodes()), clusterMax(g.numNodes()), clusterPending(g.numNodes())
+{
+    const int n = g.numNodes();
+
+    // The k-th u -> v half pairs with the k-th v -> u half: finalize() keeps
+    // each node's edges in segment order. A self-loop's halves are adjacent.
+    for (int u = 0; u < n; ++u)
+    {
+        int loop = -1;
+        for (int e = g.edgeBegin(u); e < g.edgeEnd(u); ++e)
+        {
+            int v = g.edgeTarget(e);
+            if (v == u)
+            {
+                if (loop == -1)
+                {
+                    loop = e;
+                }
+                else
+                {
+                    twin[loop] = e;
+                    twin[e] = loop;
+                    loop = -1;
+                }
+                continue;
+            }
+            if (v < u)
+                continue;
+            int k = 0;
+            for (int f = g.edgeBegin(u); f < e; ++f)
+                if (g.edgeTarget(f) == v)
+                    ++k;
+            for (int r = g.edgeBegin(v); r < g.edgeEnd(v); ++r)
+            {
+                if (g.edgeTarget(r) == u && k-- == 0)
+                {
+                    twin[e] = r;
+                    twin[r] = e;
+                    break;
+                }
+            }
+        }
+    }
+
+    BiconnectivityResult full = findBiconnectedComponents(g);
+    edgeBlock = std::move(full.edgeComponent);
+    blockParent.resize(full.numComponents);
+    blockSegments.assign(full.numComponents, 0);
+    for (int b = 0; b < full.numComponents; ++b)
+        blockParent[b] = b;
+    for (int e = 0; e < g.numEdges(); ++e)
+        if (edgeBlock[e] != -1 && tail(e) < g.edgeTarget(e))
+            ++blockSegments[edgeBlock[e]];
+    for (int u : full.articulationPoints)
+        isArt[u] = 1;
+}
+
+int DynamicCriticalPoints::blockOf(int e) const
+{
+    int b = edgeBlock[e];
+    while (blockParent[b] != b)
+    {
+        blockParent[b] = blockParent[blockParent[b]];
+        b = blockParent[b];
+    }
+    return b;
+}
+
+int DynamicCriticalPoints::newBlock(int segments)
+{
+    blockParent.push_back((int)blockParent.size());
+    blockSegments.push_back(segments);
+    return (int)blockParent.size() - 1;
+}
+
+bool DynamicCriticalPoints::usable(int e, int block) const
+{
+    return !closed[e] && edgeBlock[e] != -1 && (block == -1 || blockOf(e) == block);
+}
+
+bool DynamicCriticalPoints::isBridge(int e) const
+{
+    return !closed[e] && edgeBlock[e] != -1 && blockSegments[blockOf(e)] == 1;
+}
+
+std::vector<int> DynamicCriticalPoints::criticalPoints() const
+{
+    std::vector<int> points;
+    for (int u = 0; u < g.numNodes(); ++u)
+        if (isArt[u])
+            points.push_back(u);
+    return points;
+}
+
+std::vector<int> DynamicCriticalPoints::bridges() const
+{
+    std::vector<int> result;
+    for (int e = 0; e < g.numEdges(); ++e)
+        if (tail(e) < g.edgeTarget(e) && isBridge(e))
+            result.push_back(e);
+    return result;
+}
+
+void DynamicCriticalPoints::nextEpoch()
+{
+    if (++epoch == 0)
+    {
+        std::fill(stamp.begin(), stamp.end(), 0);
+        epoch = 1;
+    }
+}
+
+// A node is critical while its open segments lie in two or more blocks
+void DynamicCriticalPoints::refresh(int u, ClosureUpdate &update)
+{
+    int first = -1;
+    bool critical = false;
+    for (int e = g.edgeBegin(u); e < g.edgeEnd(u) && !critical; ++e)
+    {
+        if (!usable(e, -1))
+            continue;
+        int b = blockOf(e);
+        if (first == -1)
+            first = b;
+        else
+            critical = b != first;
+    }
+    if (critical != (isArt[u] != 0))
+    {
+        isArt[u] = critical;
+        (critical ? update.newlyCritical : update.noLongerCritical).push_back(u);
+    }
+}
+
+// Bidirectional BFS, always growing the side with the shorter queue, so a
+// failed search costs about twice the smaller of the two components
+bool DynamicCriticalPoints::connect(int u, int v, int block, std::vector<int> &path, size_t &visited)
+{
+    path.clear();
+    if (u == v)
+        return true;
+
+    nextEpoch();
+    std::vector<int> queue[2] = {{u}, {v}};
+    size_t head[2] = {0, 0};
+    stamp[u] = stamp[v] = epoch;
+    side[u] = 0;
+    side[v] = 1;
+    link[u] = link[v] = -1;
+
+    while (head[0] < queue[0].size() && head[1] < queue[1].size())
+    {
+        const int s = queue[0].size() - head[0] <= queue[1].size() - head[1] ? 0 : 1;
+        const int x = queue[s][head[s]++];
+        ++visited;
+        for (int f = g.edgeBegin(x); f < g.edgeEnd(x); ++f)
+        {
+            if (!usable(f, block))
+                continue;
+            int y = g.edgeTarget(f);
+            if (stamp[y] != epoch)
+            {
+                stamp[y] = epoch;
+                side[y] = (char)s;
+                link[y] = f;
+                queue[s].push_back(y);
+                continue;
+            }
+            if (side[y] == s)
+                continue;
+
+            // The trees meet on f; splice u -> a, a -> b, b -> v
+            int a = s == 0 ? x : y;
+            int b = s == 0 ? y : x;
+            for (int c = a; link[c] != -1; c = tail(link[c]))
+                path.push_back(link[c]);
+            std::reverse(path.begin(), path.end());
+            path.push_back(s == 0 ? f : twin[f]);
+            for (int c = b; link[c] != -1; c = tail(link[c]))
+                path.push_back(twin[link[c]]);
+            return true;
+        }
+    }
+    return false;
+}
+
+ClosureUpdate DynamicCriticalPoints::closeEdge(int e)
+{
+    ClosureUpdate update;
+    if (closed[e])
+        return update;
+    closed[e] = closed[twin[e]] = 1;
+    if (edgeBlock[e] == -1)
+        return update;
+
+    const int u = tail(e), v = g.edgeTarget(e);
+    const int b = blockOf(e);
+    if (--blockSegments[b] == 0)
+    {
+        // A bridge: its block is gone, and its ends may have been critical
+        // only through it
+        update.removedBridges.push_back(lowerHalf(e));
+        refresh(u, update);
+        refresh(v, update);
+        update.nodesVisited = 2;
+    }
+    else
+    {
+        splitBlock(b, u, v, update);
+    }
+    std::sort(update.newlyCritical.begin(), update.newlyCritical.end());
+    std::sort(update.noLongerCritical.begin(), update.noLongerCritical.end());
+    std::sort(update.newBridges.begin(), update.newBridges.end());
+    return update;
+}
+
+ClosureUpdate DynamicCriticalPoints::reopenEdge(int e)
+{
+    ClosureUpdate update;
+    if (!closed[e])
+        return update;
+    if (edgeBlock[e] == -1)
+    {
+        closed[e] = closed[twin[e]] = 0;
+        return update;
+    }
+
+    const int u = tail(e), v = g.edgeTarget(e);
+    std::vector<int> path;
+    bool joined = connect(u, v, -1, path, update.nodesVisited);
+    closed[e] = closed[twin[e]] = 0;
+
+    if (!joined)
+    {
+        // Joins two components: a bridge in a block of its own
+        edgeBlock[e] = edgeBlock[twin[e]] = newBlock(1);
+        update.newBridges.push_back(lowerHalf(e));
+        refresh(u, update);
+        refresh(v, update);
+    }
+    else
+    {
+        // The new cycle merges every block the path runs through; a simple
+        // path passes each of them in one contiguous run
+        std::vector<int> runs;
+        for (int f : path)
+        {
+            int b = blockOf(f);
+            if (!runs.empty() && b == runs.back())
+                continue;
+            runs.push_back(b);
+            if (blockSegments[b] == 1)
+                update.removedBridges.push_back(lowerHalf(f));
+        }
+        const int merged = runs.front();
+        int segments = 1;
+        for (int b : runs)
+        {
+            segments += blockSegments[b];
+            blockParent[b] = merged;
+        }
+        blockSegments[merged] = segments;
+        edgeBlock[e] = edgeBlock[twin[e]] = merged;
+
+        refresh(u, update);
+        for (int f : path)
+            refresh(g.edgeTarget(f), update);
+    }
+    std::sort(update.noLongerCritical.begin(), update.noLongerCritical.end());
+    std::sort(update.newlyCritical.begin(), update.newlyCritical.end());
+    std::sort(update.removedBridges.begin(), update.removedBridges.end());
+    return update;
+}
+
+void DynamicCriticalPoints::splitBlock(int b, int u, int v, ClosureUpdate &update)
+{
+    std::vector<int> detour;
+    if (!connect(u, v, b, detour, update.nodesVisited))
+        throw std::logic_error("DynamicCriticalPoints: block without a detour");
+
+    // Parallel segment left: nothing splits, but it may now stand alone
+    const int k = (int)detour.size();
+    if (k == 1)
+    {
+        if (blockSegments[b] == 1)
+            update.newBridges.push_back(lowerHalf(detour[0]));
+        return;
+    }
+
+    nextEpoch();
+    std::vector<int> path{u};
+    for (int f : detour)
+        path.push_back(g.edgeTarget(f));
+    for (int i = 0; i <= k; ++i)
+    {
+        stamp[path[i]] = epoch;
+        pathIndex[path[i]] = i;
+    }
+    auto onPath = [&](int x)
+    { return stamp[x] == epoch && pathIndex[x] >= 0; };
+
+    // Clusters: union-find through link, span and unscanned count at roots
+    auto cluster = [&](int x)
+    {
+        while (link[x] != x)
+        {
+            link[x] = link[link[x]];
+            x = link[x];
+        }
+        return x;
+    };
+    auto attach = [&](int root, int i)
+    {
+        clusterMin[root] = std::min(clusterMin[root], i);
+        clusterMax[root] = std::max(clusterMax[root], i);
+    };
+    std::vector<int> found;
+    auto discover = [&](int y, int root, int i)
+    {
+        stamp[y] = epoch;
+        pathIndex[y] = -1;
+        if (root == -1)
+        {
+            link[y] = y;
+            clusterMin[y] = clusterMax[y] = i;
+            clusterPending[y] = 1;
+        }
+        else
+        {
+            link[y] = root;
+            ++clusterPending[root];
+        }
+        found.push_back(y);
+    };
+
+    std::vector<std::pair<int, int>> chords;
+    for (int i = 0; i <= k; ++i)
+    {
+        for (int f = g.edgeBegin(path[i]); f < g.edgeEnd(path[i]); ++f)
+        {
+            if (!usable(f, b))
+                continue;
+            int y = g.edgeTarget(f);
+            if (onPath(y))
+            {
+                if (pathIndex[y] > i + 1)
+                    chords.emplace_back(i, pathIndex[y]);
+            }
+            else if (stamp[y] != epoch)
+            {
+                discover(y, -1, i);
+            }
+            else
+            {
+                attach(cluster(y), i);
+            }
+        }
+    }
+    update.nodesVisited += k + 1;
+
+    // Inner path positions nothing spans, and whether each is proven to
+    // separate: every cluster on one side of it is exhausted
+    std::vector<int> cuts;
+    int openMin = 0;
+    auto settled = [&]()
+    {
+        std::vector<int> cover(k + 1, 0);
+        auto span = [&](int a, int c)
+        {
+            if (c - a >= 2)
+            {
+                ++cover[a + 1];
+                --cover[c];
+            }
+        };
+        for (const auto &[a, c] : chords)
+            span(a, c);
+        openMin = k + 1;
+        int openMax = -1;
+        for (int x : found)
+        {
+            if (link[x] != x)
+                continue;
+            span(clusterMin[x], clusterMax[x]);
+            if (clusterPending[x] > 0)
+            {
+                openMin = std::min(openMin, clusterMin[x]);
+                openMax = std::max(openMax, clusterMax[x]);
+            }
+        }
+        cuts.clear();
+        for (int i = 1, covered = cover[0]; i < k; ++i)
+        {
+            covered += cover[i];
+            if (covered > 0)
+                continue;
+            if (i > openMin && i < openMax)
+                return false;
+            cuts.push_back(i);
+        }
+        return true;
+    };
+
+    size_t next = 0;
+    size_t checkAt = 0;
+    for (;;)
+    {
+        if (next == found.size() || next >= checkAt)
+        {
+            if (settled())
+                break;
+            checkAt = 2 * next + 64;
+        }
+        const int x = found[next++];
+        --clusterPending[cluster(x)];
+        ++update.nodesVisited;
+        for (int f = g.edgeBegin(x); f < g.edgeEnd(x); ++f)
+        {
+            if (!usable(f, b))
+                continue;
+            int y = g.edgeTarget(f);
+            if (onPath(y))
+            {
+                attach(cluster(x), pathIndex[y]);
+            }
+            else if (stamp[y] != epoch)
+            {
+                discover(y, cluster(x), 0);
+            }
+            else
+            {
+                int rx = cluster(x), ry = cluster(y);
+                if (rx == ry)
+                    continue;
+                link[ry] = rx;
+                attach(rx, clusterMin[ry]);
+                attach(rx, clusterMax[ry]);
+                clusterPending[rx] += clusterPending[ry];
+            }
+        }
+    }
+    if (cuts.empty())
+        return;
+
+    // The pieces between consecutive cuts become blocks of their own. The
+    // one piece still holding an unexhausted cluster keeps b; the others
+    // were fully scanned and get fresh ids.
+    std::vector<int> bounds{0};
+    bounds.insert(bounds.end(), cuts.begin(), cuts.end());
+    bounds.push_back(k);
+    auto pieceOf = [&](int a)
+    { return (int)(std::upper_bound(bounds.begin(), bounds.end(), a) - bounds.begin()) - 1; };
+
+    const int pieces = (int)cuts.size() + 1;
+    const int keep = openMin <= k ? pieceOf(openMin) : -1;
+    std::vector<int> pieceBlock(pieces, -1);
+    std::vector<int> halves(pieces, 0);
+    std::vector<int> anyHalf(pieces, -1);
+    for (int p = 0; p < pieces; ++p)
+        if (p != keep)
+            pieceBlock[p] = newBlock(0);
+
+    auto relabel = [&](int f, int piece)
+    {
+        if (piece == keep)
+            return;
+        edgeBlock[f] = pieceBlock[piece];
+        ++halves[piece];
+        anyHalf[piece] = f;
+    };
+    auto clusterPiece = [&](int x)
+    {
+        int root = cluster(x);
+        return clusterPending[root] > 0 ? keep : pieceOf(clusterMin[root]);
+    };
+    for (int x : found)
+    {
+        int piece = clusterPiece(x);
+        if (piece == keep)
+            continue;
+        for (int f = g.edgeBegin(x); f < g.edgeEnd(x); ++f)
+            if (usable(f, b))
+                relabel(f, piece);
+    }
+    for (int i = 0; i <= k; ++i)
+    {
+        for (int f = g.edgeBegin(path[i]); f < g.edgeEnd(path[i]); ++f)
+        {
+            if (!usable(f, b))
+                continue;
+            int y = g.edgeTarget(f);
+            relabel(f, onPath(y) ? pieceOf(std::min(i, pathIndex[y])) : clusterPiece(y));
+        }
+    }
+
+    for (int p = 0; p < pieces; ++p)
+    {
+        if (p == keep)
+            continue;
+        int segments = halves[p] / 2;
+        blockSegments[pieceBlock[p]] = segments;
+        blockSegments[b] -= segments;
+        if (segments == 1)
+            update.newBridges.push_back(lowerHalf(anyHalf[p]));
+    }
+    for (int c : cuts)
+    {
+        if (!isArt[path[c]])
+        {
+            isArt[path[c]] = 1;
+            update.newlyCritical.push_back(path[c]);
+        }
+    }
+}
@@ -3,6 +3,8 @@
 #include <cmath>
 #include <iomanip>
 #include <limits>
+#include <algorithm>
+#include <cstdlib>
 #include "graph.hpp"
 #include "json.hpp"
 
@@ -17,15 +19,440 @@ int Graph::getNodeIndex(double lat, double lon) {
     if (it != coordToIndex.end()) {
         return it->second;
     }
-    int index = (int)nodes.size();
-    nodes.push_back({lat, lon, false, {}});
+    int index = (int)pendingNodes.size();
+    pendingNodes.push_back({lat, lon});
     coordToIndex[key] = index;
     return index;
 }
 
+// Queue an undirected segment; both directions are materialized by finalize()
+void Graph::addEdge(int u, int v, double weight) {
+    EdgeWeight w = weightFromCost(weight);
+    addSegment(u, v, w, w);
+}
+
+void Graph::addSegment(int u, int v, EdgeWeight forward, EdgeWeight backward) {
+    if (pendingWayIds.empty())
+        pendingWayIds.push_back(-1);
+    pendingEdges.push_back({u, v, forward, backward, EdgeAttributes{}.pack(), 0});
+}
+
+// Consecutive segments of one way share its way table entry
+void Graph::addRoad(int u, int v, double metres, const EdgeAttributes& attributes, int64_t wayId) {
+    if (pendingWayIds.empty())
+        pendingWayIds.push_back(-1);
+    if (wayId != -1 && pendingWayIds.back() != wayId)
+        pendingWayIds.push_back(wayId);
+    uint32_t way = wayId == -1 ? 0 : (uint32_t)pendingWayIds.size() - 1;
+
+    pendingEdges.push_back({u, v, profileWeight(Profile::Car, metres, attributes),
+                            profileWeight(Profile::Car, metres, attributes.reversed()), attributes.pack(), way});
+}
+
+double Graph::defaultSpeedKmh(RoadClass roadClass) {
+    switch (roadClass) {
+    case RoadClass::Motorway: return 90.0;
+    case RoadClass::Trunk: return 70.0;
+    case RoadClass::Primary: return 55.0;
+    case RoadClass::Secondary: return 45.0;
+    case RoadClass::Tertiary: return 40.0;
+    case RoadClass::Unclassified: return 30.0;
+    case RoadClass::Residential: return 25.0;
+    case RoadClass::LivingStreet: return 10.0;
+    case RoadClass::Service: return 15.0;
+    case RoadClass::Track: return 15.0;
+    case RoadClass::Pedestrian:
+    case RoadClass::Footway:
+    case RoadClass::Path:
+    case RoadClass::Steps: return 5.0;
+    case RoadClass::Cycleway: return 15.0;
+    default: return 30.0;
+    }
+}
+
+EdgeWeight Graph::profileWeight(Profile profile, double metres, const EdgeAttributes& a) {
+    constexpr double WALKING_KMH = 5.0;
+    constexpr double TWO_WHEELER_MAX_KMH = 50.0;
+
+    if (profile == Profile::Distance)
+        return weightFromCost(metres);
+    if (profile == Profile::Foot)
+        return a.roadClass == RoadClass::Motorway ? INF_WEIGHT : weightFromCost(metres * 3.6 / WALKING_KMH);
+
+    switch (a.roadClass) {
+    case RoadClass::Pedestrian:
+    case RoadClass::Footway:
+    case RoadClass::Cycleway:
+    case RoadClass::Path:
+    case RoadClass::Steps:
+        return INF_WEIGHT;
+    default:
+        break;
+    }
+    if (a.oneway == OneWay::Against)
+        return INF_WEIGHT;
+    double speedKmh = a.maxSpeedKmh > 0 ? a.maxSpeedKmh : defaultSpeedKmh(a.roadClass);
+    if (profile == Profile::Bike)
+        speedKmh = std::min(speedKmh, TWO_WHEELER_MAX_KMH);
+    return weightFromCost(metres * 3.6 / speedKmh);
+}
+
+// Reverse CSR: bucket every forward edge under its head node
+static void buildReverse(int n, const std::vector<int>& offsets, const std::vector<int>& targets,
+                         std::vector<int>& revOffsets, std::vector<int>& revSources, std::vector<int>& revEdges) {
+    revOffsets.assign(n + 1, 0);
+    for (int v : targets)
+        ++revOffsets[v + 1];
+    for (int i = 0; i < n; ++i)
+        revOffsets[i + 1] += revOffsets[i];
+    revSources.resize(targets.size());
+    revEdges.resize(targets.size());
+    std::vector<int> cursor(revOffsets.begin(), revOffsets.end() - 1);
+    for (int u = 0; u < n; ++u) {
+        for (int e = offsets[u]; e < offsets[u + 1]; ++e) {
+            int r = cursor[targets[e]]++;
+            revSources[r] = u;
+            revEdges[r] = e;
+        }
+    }
+}
+
+// Position of cell (x, y) along a Hilbert curve filling a 2^16 x 2^16 grid
+static uint32_t hilbertIndex(uint32_t x, uint32_t y) {
+    uint32_t d = 0;
+    for (uint32_t s = 1u << 15; s > 0; s >>= 1) {
+        uint32_t rx = (x & s) ? 1 : 0;
+        uint32_t ry = (y & s) ? 1 : 0;
+        d += s * s * ((3 * rx) ^ ry);
+        // Rotate the quadrant so the curve stays continuous
+        if (ry == 0) {
+            if (rx == 1) {
+                x = s - 1 - x;
+                y = s - 1 - y;
+            }
+            std::swap(x, y);
+        }
+    }
+    return d;
+}
+
+// Build-phase ids sorted along a Hilbert curve over the bounding box, so
+// nodes close on the map are close in memory and a search's frontier
+// touches fewer cache lines. Ties keep input order.
+static std::vector<int> hilbertOrder(const std::vector<Node>& nodes) {
+    double minLat = std::numeric_limits<double>::max(), maxLat = -minLat;
+    double minLon = minLat, maxLon = -minLat;
+    for (const Node& nd : nodes) {
+        minLat = std::min(minLat, nd.lat);
+        maxLat = std::max(maxLat, nd.lat);
+        minLon = std::min(minLon, nd.lon);
+        maxLon = std::max(maxLon, nd.lon);
+    }
+    const double cells = 65535.0;
+    const double latScale = maxLat > minLat ? cells / (maxLat - minLat) : 0.0;
+    const double lonScale = maxLon > minLon ? cells / (maxLon - minLon) : 0.0;
+
+    std::vector<std::pair<uint32_t, int>> keyed(nodes.size());
+    for (size_t i = 0; i < nodes.size(); ++i) {
+        uint32_t x = (uint32_t)((nodes[i].lon - minLon) * lonScale);
+        uint32_t y = (uint32_t)((nodes[i].lat - minLat) * latScale);
+        keyed[i] = {hilbertIndex(x, y), (int)i};
+    }
+    std::sort(keyed.begin(), keyed.end());
+
+    std::vector<int> order(nodes.size());
+    for (size_t i = 0; i < keyed.size(); ++i)
+        order[i] = keyed[i].second;
+    return order;
+}
+
+// Build the CSR arrays from the queued segments with a counting sort,
+// keeping each node's edges in insertion order
+void Graph::finalize(NodeOrder order) {
+    const int n = (int)pendingNodes.size();
+
+    // Renumber first: node i of the new order is build-phase node ids[i]
+    std::vector<int> ids;
+    if (order == NodeOrder::Hilbert) {
+        ids = hilbertOrder(pendingNodes);
+    } else {
+        ids.resize(n);
+        for (int i = 0; i < n; ++i)
+            ids[i] = i;
+    }
+    std::vector<int> renumber(n);
+    std::vector<Node> ordered(n);
+    for (int i = 0; i < n; ++i) {
+        renumber[ids[i]] = i;
+        ordered[i] = pendingNodes[ids[i]];
+    }
+    for (auto& pe : pendingEdges) {
+        pe.u = renumber[pe.u];
+        pe.v = renumber[pe.v];
+    }
+
+    std::vector<int> offsets(n + 1, 0);
+    for (const auto& pe : pendingEdges) {
+        ++offsets[pe.u + 1];
+        ++offsets[pe.v + 1];
+    }
+    for (int i = 0; i < n; ++i)
+        offsets[i + 1] += offsets[i];
+
+    std::vector<int> targets(offsets[n]);
+    std::vector<EdgeWeight> weights(offsets[n]);
+    std::vector<uint16_t> attributes(offsets[n]);
+    std::vector<uint32_t> ways(offsets[n]);
+    std::vector<int> cursor(offsets.begin(), offsets.end() - 1);
+    for (const auto& pe : pendingEdges) {
+        int a = cursor[pe.u]++;
+        targets[a] = pe.v;
+        weights[a] = pe.forward;
+        attributes[a] = pe.attributes;
+        ways[a] = pe.way;
+        int b = cursor[pe.v]++;
+        targets[b] = pe.u;
+        weights[b] = pe.backward;
+        attributes[b] = EdgeAttributes::unpack(pe.attributes).reversed().pack();
+        ways[b] = pe.way;
+    }
+    if (pendingWayIds.empty())
+        pendingWayIds.push_back(-1);
+
+    std::vector<int> revOffsets, revSources, revEdges;
+    buildReverse(n, offsets, targets, revOffsets, revSources, revEdges);
+
+    mapping.reset();
+    nodes.assign(std::move(ordered));
+    edgeOffsets.assign(std::move(offsets));
+    edgeTargets.assign(std::move(targets));
+    edgeWeights.assign(std::move(weights));
+    reverseOffsets.assign(std::move(revOffsets));
+    reverseSources.assign(std::move(revSources));
+    reverseEdges.assign(std::move(revEdges));
+    edgeAttrs.assign(std::move(attributes));
+    edgeWays.assign(std::move(ways));
+    wayIds.assign(std::move(pendingWayIds));
+    originalIds.assign(std::move(ids));
+    buildNodeIndexes();
+
+    // Build-phase state is not needed by any query
+    std::vector<Node>().swap(pendingNodes);
+    std::vector<PendingEdge>().swap(pendingEdges);
+    std::vector<int64_t>().swap(pendingWayIds);
+    std::unordered_map<std::pair<double, double>, int, PairHash>().swap(coordToIndex);
+}
+
+// Copy the adjacency node by node, skipping removed halves and appending
+// added segments; only the reverse CSR is rebuilt from scratch
+Graph Graph::edited(const std::vector<Node>& extraNodes, const std::vector<int>& removedEdges,
+                    const std::vector<Segment>& addedSegments) const {
+    const int n = numNodes();
+    const int total = n + (int)extraNodes.size();
+    std::vector<char> removed(numEdges(), 0);
+    for (int e : removedEdges)
+        removed[e] = 1;
+
+    std::vector<int> added(total + 1, 0);
+    for (const Segment& s : addedSegments) {
+        ++added[s.u + 1];
+        ++added[s.v + 1];
+    }
+    std::vector<int> offsets(total + 1, 0);
+    for (int u = 0; u < total; ++u) {
+        int kept = 0;
+        if (u < n)
+            for (int e = edgeBegin(u); e < edgeEnd(u); ++e)
+                kept += !removed[e];
+        offsets[u + 1] = offsets[u] + kept + added[u + 1];
+    }
+
+    std::vector<int> targets(offsets[total]);
+    std::vector<EdgeWeight> weights(offsets[total]);
+    std::vector<int> cursor(offsets.begin(), offsets.end() - 1);
+    for (int u = 0; u < n; ++u) {
+        for (int e = edgeBegin(u); e < edgeEnd(u); ++e) {
+            if (removed[e])
+                continue;
+            int a = cursor[u]++;
+            targets[a] = edgeTargets[e];
+            weights[a] = edgeWeights[e];
+        }
+    }
+    for (const Segment& s : addedSegments) {
+        int a = cursor[s.u]++;
+        targets[a] = s.v;
+        weights[a] = s.forward;
+        int b = cursor[s.v]++;
+        targets[b] = s.u;
+        weights[b] = s.backward;
+    }
+
+    std::vector<int> revOffsets, revSources, revEdges;
+    buildReverse(total, offsets, targets, revOffsets, revSources, revEdges);
+
+    Graph copy;
+    std::vector<Node> allNodes(nodes.begin(), nodes.end());
+    allNodes.insert(allNodes.end(), extraNodes.begin(), extraNodes.end());
+    std::vector<int> ids(originalIds.begin(), originalIds.end());
+    std::vector<UnitVector> vectors(unitVectors.begin(), unitVectors.end());
+    std::vector<int> toNode(originalToNode.begin(), originalToNode.end());
+    for (int u = n; u < total; ++u) {
+        double xyz[3];
+        SpatialIndex::toUnitVector(allNodes[u].lat, allNodes[u].lon, xyz);
+        vectors.push_back({xyz[0], xyz[1], xyz[2]});
+        ids.push_back(u);
+        toNode.push_back(u);
+    }
+    copy.nodes.assign(std::move(allNodes));
+    copy.originalIds.assign(std::move(ids));
+    copy.unitVectors.assign(std::move(vectors));
+    copy.originalToNode.assign(std::move(toNode));
+    copy.edgeOffsets.assign(std::move(offsets));
+    copy.edgeTargets.assign(std::move(targets));
+    copy.edgeWeights.assign(std::move(weights));
+    copy.reverseOffsets.assign(std::move(revOffsets));
+    copy.reverseSources.assign(std::move(revSources));
+    copy.reverseEdges.assign(std::move(revEdges));
+
+    // New segments may bound their straight line less tightly than any edge here
+    copy.minCostPerMetre = minCostPerMetre;
+    for (const Segment& s : addedSegments) {
+        double metres = copy.chordMetres(s.u, s.v);
+        for (EdgeWeight w : {s.forward, s.backward})
+            if (isPassable(w) && metres > 0.0)
+                copy.minCostPerMetre = std::min(copy.minCostPerMetre, (double)w / metres);
+    }
+    return copy;
+}
+
+void Graph::buildNodeIndexes() {
+    auto index = std::make_shared<SpatialIndex>();
+    index->build(nodes.data(), nodes.size());
+    spatialIndex = std::move(index);
+    std::vector<UnitVector> vectors(nodes.size());
+    for (size_t i = 0; i < nodes.size(); ++i) {
+        double xyz[3];
+        SpatialIndex::toUnitVector(nodes[i].lat, nodes[i].lon, xyz);
+        vectors[i] = {xyz[0], xyz[1], xyz[2]};
+    }
+    unitVectors.assign(std::move(vectors));
+    std::vector<int> toNode(nodes.size(), -1);
+    for (size_t i = 0; i < nodes.size(); ++i)
+        toNode[originalIds[i]] = (int)i;
+    originalToNode.assign(std::move(toNode));
+    computeCostPerMetre();
+    computeUsableNodes();
+}
+
+void Graph::computeUsableNodes() {
+    std::vector<uint8_t> usable(nodes.size(), 0);
+    for (int u = 0; u < numNodes(); ++u) {
+        for (int e = edgeBegin(u); e < edgeEnd(u); ++e) {
+            if (isPassable(edgeWeights[e]))
+                usable[u] = usable[edgeTargets[e]] = 1;
+        }
+    }
+    usableNodes.assign(std::move(usable));
+}
+
+void Graph::computeCostPerMetre() {
+    // Chords obey the triangle inequality, so the ratio to them bounds
+    // whole paths as well as single edges
+    double best = std::numeric_limits<double>::infinity();
+    for (int u = 0; u < numNodes(); ++u) {
+        for (int e = edgeBegin(u); e < edgeEnd(u); ++e) {
+            double metres = chordMetres(u, edgeTargets[e]);
+            if (isPassable(edgeWeights[e]) && metres > 0.0)
+                best = std::min(best, (double)edgeWeights[e] / metres);
+        }
+    }
+    minCostPerMetre = std::isfinite(best) ? best : 0.0;
+}
+
+Graph Graph::withProfile(Profile profile) const {
+    if (edgeAttrs.size() != edgeTargets.size())
+        throw std::runtime_error("withProfile: graph has no edge attributes");
+    if (profile == Profile::Car)
+        return withWeights(profile, {});
+
+    // Each edge is a straight segment, so its length is the haversine
+    // between its ends, as when the road was added
+    std::vector<EdgeWeight> weights(edgeTargets.size());
+    for (int u = 0; u < numNodes(); ++u)
+        for (int e = edgeBegin(u); e < edgeEnd(u); ++e)
+            weights[e] = profileWeight(profile, calDistance(u, edgeTargets[e]), edgeAttributes(e));
+    return withWeights(profile, std::move(weights));
+}
+
+Graph Graph::withWeights(Profile profile, std::vector<EdgeWeight> weights) const {
+    if (!weights.empty() && weights.size() != edgeTargets.size())
+        throw std::runtime_error("withWeights: expected one weight per edge");
+
+    Graph view;
+    view.nodes.view(nodes.data(), nodes.size());
+    view.edgeOffsets.view(edgeOffsets.data(), edgeOffsets.size());
+    view.edgeTargets.view(edgeTargets.data(), edgeTargets.size());
+    view.reverseOffsets.view(reverseOffsets.data(), reverseOffsets.size());
+    view.reverseSources.view(reverseSources.data(), reverseSources.size());
+    view.reverseEdges.view(reverseEdges.data(), reverseEdges.size());
+    view.edgeAttrs.view(edgeAttrs.data(), edgeAttrs.size());
+    view.edgeWays.view(edgeWays.data(), edgeWays.size());
+    view.wayIds.view(wayIds.data(), wayIds.size());
+    view.originalIds.view(originalIds.data(), originalIds.size());
+    view.originalToNode.view(originalToNode.data(), originalToNode.size());
+    view.unitVectors.view(unitVectors.data(), unitVectors.size());
+    view.spatialIndex = spatialIndex;
+    view.mapping = mapping;
+    view.costProfile = profile;
+
+    if (weights.empty()) {
+        view.edgeWeights.view(edgeWeights.data(), edgeWeights.size());
+        view.minCostPerMetre = minCostPerMetre;
+        view.usableNodes.view(usableNodes.data(), usableNodes.size());
+        return view;
+    }
+    view.edgeWeights.assign(std::move(weights));
+    view.computeCostPerMetre();
+    view.computeUsableNodes();
+    return view;
+}
+
+// Linear scan of u's edge range
+int Graph::findEdge(int u, int v) const {
+    for (int e = edgeBegin(u); e < edgeEnd(u); ++e) {
+        if (edgeTargets[e] == v)
+            return e;
+    }
+    return -1;
+}
+
+double Graph::chordMetres(int u, int v) const {
+    const UnitVector& a = unitVectors[u];
+    const UnitVector& b = unitVectors[v];
+    double dx = a.x - b.x, dy = a.y - b.y, dz = a.z - b.z;
+    return std::sqrt(dx * dx + dy * dy + dz * dz) * EARTH_RADIUS;
+}
+
+int Graph::cheapestEdge(int u, int v) const {
+    int best = -1;
+    for (int e = edgeBegin(u); e < edgeEnd(u); ++e) {
+        if (edgeTargets[e] == v && isPassable(edgeWeights[e]) &&
+            (best == -1 || edgeWeights[e] < edgeWeights[best]))
+            best = e;
+    }
+    return best;
+}
+
+double Graph::pathMetres(const std::vector<int>& path) const {
+    double metres = 0.0;
+    for (size_t i = 0; i + 1 < path.size(); ++i)
+        metres += calDistance(path[i], path[i + 1]);
+    return metres;
+}
+
 // Haversine formula
 double Graph::haversine(double lat1, double lon1, double lat2, double lon2) {
-    static constexpr double R = 6371000.0; // meters
     double rLat1 = lat1 * M_PI / 180.0;
     double rLat2 = lat2 * M_PI / 180.0;
     double dLat = (lat2 - lat1) * M_PI / 180.0;
@@ -35,7 +462,7 @@ double Graph::haversine(double lat1, double lon1, double lat2, double lon2) {
                std::cos(rLat1) * std::cos(rLat2) *
                std::sin(dLon/2) * std::sin(dLon/2);
     double c = 2 * std::atan2(std::sqrt(a), std::sqrt(1 - a));
-    return R * c;
+    return EARTH_RADIUS * c;
 }
 
 // Calculate distance between two nodes by index
@@ -48,48 +475,322 @@ double Graph::calDistance(int id1, int id2) const {
     return haversine(n1.lat, n1.lon, n2.lat, n2.lon);
 }
 
-// Load GeoJSON file to build graph
-void Graph::loadFromGeoJSON(const std::string& filename) {
-    std::ifstream in(filename);
-    if (!in.is_open())
-        throw std::runtime_error("Cannot open GeoJSON file: " + filename);
+namespace {
+
+// SAX consumer for GeoJSON FeatureCollections. Only the nesting that leads to
+// features[*].geometry.{type,coordinates} is tracked; everything else is
+// skipped as it streams past, so no DOM is ever built.
+class GeoJSONSaxHandler : public json::json_sax_t {
+public:
+    explicit GeoJSONSaxHandler(Graph& graph) : graph(graph) {}
+
+    bool sawFeatures() const { return featuresSeen; }
+    const std::string& errorMessage() const { return error; }
+
+    bool null() override { return true; }
+    bool boolean(bool) override { return true; }
+    bool number_integer(number_integer_t val) override { return number((double)val); }
+    bool number_unsigned(number_unsigned_t val) override { return number((double)val); }
+    bool number_float(number_float_t val, const string_t&) override { return number(val); }
+    bool binary(binary_t&) override { return true; }
+
+    bool string(string_t& val) override {
+        if (stack.empty())
+            return true;
+        const Frame& top = stack.back();
+        if (top.role == Role::Geometry && top.key == "type") {
+            geomType = val;
+            // Once the type is known, buffered positions can be flushed
+            if (geomType == "LineString")
+                flushBuffered();
+        } else if (top.role == Role::Properties) {
+            property(top.key, val);
+        } else if (top.role == Role::Feature && top.key == "id") {
+            wayId = parseWayId(val);
+        }
+        return true;
+    }
 
-    json doc;
-    try {
-        in >> doc;
-    } catch (const json::parse_error& e) {
-        throw std::runtime_error(std::string("JSON parse error: ") + e.what());
+    bool key(string_t& val) override {
+        stack.back().key = val;
+        return true;
     }
 
-    if (!doc.contains("features") || !doc["features"].is_array())
-        throw std::runtime_error("Invalid GeoJSON: missing 'features' array");
+    bool start_object(std::size_t) override {
+        Role role = childRole(false);
+        if (role == Role::Feature) {
+            roadAttributes = {};
+            onewayTag.clear();
+            roundabout = false;
+            wayId = -1;
+            segments.clear();
+        }
+        if (role == Role::Geometry) {
+            geomType.clear();
+            coords.clear();
+            havePrev = false;
+        }
+        stack.push_back({role, {}, 0, 0.0, 0.0});
+        return true;
+    }
 
-    for (auto& feature : doc["features"]) {
-        if (!feature.contains("geometry") || !feature["geometry"].contains("type"))
-            continue;
+    bool end_object() override {
+        Role role = stack.back().role;
+        stack.pop_back();
+        if (role == Role::Geometry) {
+            if (geomType == "LineString")
+                flushBuffered();
+            coords.clear();
+        }
+        if (role == Role::Feature)
+            addRoads();
+        return true;
+    }
 
-        auto& geom = feature["geometry"];
-        if (geom["type"] == "LineString") {
-            auto& coords = geom["coordinates"];
-            if (!coords.is_array() || coords.size() < 2)
-                continue;
+    bool start_array(std::size_t) override {
+        Role role = childRole(true);
+        if (role == Role::Features)
+            featuresSeen = true;
+        stack.push_back({role, {}, 0, 0.0, 0.0});
+        return true;
+    }
 
-            for (size_t i = 1; i < coords.size(); ++i) {
-                double lon1 = coords[i - 1][0].get<double>();
-                double lat1 = coords[i - 1][1].get<double>();
-                double lon2 = coords[i][0].get<double>();
-                double lat2 = coords[i][1].get<double>();
+    bool end_array() override {
+        Frame frame = stack.back();
+        stack.pop_back();
+        if (frame.role == Role::Position && frame.count >= 2)
+            position(frame.lat, frame.lon);
+        return true;
+    }
 
-                int u = getNodeIndex(lat1, lon1);
-                int v = getNodeIndex(lat2, lon2);
-                double dist = haversine(lat1, lon1, lat2, lon2);
+    bool parse_error(std::size_t, const std::string&, const nlohmann::detail::exception& ex) override {
+        error = ex.what();
+        return false;
+    }
 
-                nodes[u].neighbors.push_back({v, dist});
-                nodes[v].neighbors.push_back({u, dist});
-            }
+private:
+    enum class Role { Other, Root, Features, Feature, Properties, Geometry, Coordinates, Position };
+
+    struct Frame {
+        Role role;
+        std::string key;  // last key seen, objects only
+        int count;        // components seen, positions only
+        double lat;
+        double lon;
+    };
+
+    // Role of a container about to be opened, from its parent and key
+    Role childRole(bool isArray) const {
+        if (stack.empty())
+            return isArray ? Role::Other : Role::Root;
+        const Frame& parent = stack.back();
+        switch (parent.role) {
+        case Role::Root:
+            return (isArray && parent.key == "features") ? Role::Features : Role::Other;
+        case Role::Features:
+            return isArray ? Role::Other : Role::Feature;
+        case Role::Feature:
+            if (!isArray && parent.key == "geometry")
+                return Role::Geometry;
+            return (!isArray && parent.key == "properties") ? Role::Properties : Role::Other;
+        case Role::Geometry:
+            return (isArray && parent.key == "coordinates") ? Role::Coordinates : Role::Other;
+        case Role::Coordinates:
+            return isArray ? Role::Position : Role::Other;
+        default:
+            return Role::Other;
         }
     }
 
+    bool number(double val) {
+        if (stack.empty())
+            return true;
+        Frame& frame = stack.back();
+        if (frame.role == Role::Position) {
+            if (frame.count == 0)
+                frame.lon = val;
+            else if (frame.count == 1)
+                frame.lat = val;
+            ++frame.count;
+        } else if (frame.role == Role::Properties) {
+            if (frame.key == "maxspeed")
+                roadAttributes.maxSpeedKmh = clampSpeed(val);
+            else if (isWayIdKey(frame.key))
+                wayId = (int64_t)val;
+        } else if (frame.role == Role::Feature && frame.key == "id") {
+            wayId = (int64_t)val;
+        }
+        return true;
+    }
+
+    static bool isWayIdKey(const std::string& key) {
+        return key == "@id" || key == "id" || key == "osm_id";
+    }
+
+    // String properties of the current feature; numbers go through number()
+    void property(const std::string& key, const std::string& val) {
+        if (key == "highway")
+            roadAttributes.roadClass = parseRoadClass(val);
+        else if (key == "oneway")
+            onewayTag = val;
+        else if (key == "junction")
+            roundabout = val == "roundabout";
+        else if (key == "maxspeed")
+            roadAttributes.maxSpeedKmh = parseMaxSpeed(val);
+        else if (isWayIdKey(key))
+            wayId = parseWayId(val);
+    }
+
+    static RoadClass parseRoadClass(std::string val) {
+        const std::string link = "_link";
+        if (val.size() > link.size() && val.compare(val.size() - link.size(), link.size(), link) == 0)
+            val.resize(val.size() - link.size());
+        static const std::pair<const char*, RoadClass> classes[] = {
+            {"motorway", RoadClass::Motorway},
+            {"trunk", RoadClass::Trunk},
+            {"primary", RoadClass::Primary},
+            {"secondary", RoadClass::Secondary},
+            {"tertiary", RoadClass::Tertiary},
+            {"unclassified", RoadClass::Unclassified},
+            {"road", RoadClass::Unclassified},
+            {"residential", RoadClass::Residential},
+            {"living_street", RoadClass::LivingStreet},
+            {"service", RoadClass::Service},
+            {"track", RoadClass::Track},
+            {"pedestrian", RoadClass::Pedestrian},
+            {"footway", RoadClass::Footway},
+            {"bridleway", RoadClass::Footway},
+            {"corridor", RoadClass::Footway},
+            {"cycleway", RoadClass::Cycleway},
+            {"path", RoadClass::Path},
+            {"steps", RoadClass::Steps},
+        };
+        for (const auto& c : classes)
+            if (val == c.first)
+                return c.second;
+        return RoadClass::Unknown;
+    }
+
+    static uint8_t clampSpeed(double kmh) {
+        return kmh < 1.0 ? 0 : (uint8_t)std::min(255.0, std::round(kmh));
+    }
+
+    // "60", "60 km/h" or "40 mph"; "none", "walk" and the like count as untagged
+    static uint8_t parseMaxSpeed(const std::string& val) {
+        char* end = nullptr;
+        double speed = std::strtod(val.c_str(), &end);
+        if (end == val.c_str())
+            return 0;
+        if (val.find("mph") != std::string::npos)
+            speed *= 1.609344;
+        return clampSpeed(speed);
+    }
+
+    // "way/123" (Overpass exports) or a bare number; other element types are not ways
+    static int64_t parseWayId(const std::string& val) {
+        std::string digits = val.compare(0, 4, "way/") == 0 ? val.substr(4) : val;
+        if (digits.empty() || digits.find_first_not_of("0123456789") != std::string::npos)
+            return -1;
+        return std::stoll(digits);
+    }
+
+    // Queue the feature's segments once its properties are known, which
+    // may come after the geometry. Motorways and roundabouts are one-way
+    // unless tagged otherwise.
+    void addRoads() {
+        if (onewayTag == "yes" || onewayTag == "true" || onewayTag == "1")
+            roadAttributes.oneway = OneWay::Along;
+        else if (onewayTag == "-1" || onewayTag == "reverse")
+            roadAttributes.oneway = OneWay::Against;
+        else if (onewayTag.empty() && (roadAttributes.roadClass == RoadClass::Motorway || roundabout))
+            roadAttributes.oneway = OneWay::Along;
+        for (const auto& seg : segments)
+            graph.addRoad(seg.u, seg.v, seg.metres, roadAttributes, wayId);
+        segments.clear();
+    }
+
+    // A completed [lon, lat] position of the current geometry. Positions seen
+    // before the geometry's "type" are buffered; afterwards they go straight
+    // into the graph as segments.
+    void position(double lat, double lon) {
+        if (geomType == "LineString")
+            segmentTo(lat, lon);
+        else if (geomType.empty())
+            coords.emplace_back(lat, lon);
+    }
+
+    void flushBuffered() {
+        for (const auto& c : coords)
+            segmentTo(c.first, c.second);
+        coords.clear();
+    }
+
+    void segmentTo(double lat, double lon) {
+        if (havePrev) {
+            int u = graph.getNodeIndex(prevLat, prevLon);
+            int v = graph.getNodeIndex(lat, lon);
+            segments.push_back({u, v, Graph::haversine(prevLat, prevLon, lat, lon)});
+        }
+        prevLat = lat;
+        prevLon = lon;
+        havePrev = true;
+    }
+
+    struct Segment {
+        int u;
+        int v;
+        double metres;
+    };
+
+    Graph& graph;
+    std::vector<Frame> stack;
+
+    // Current feature
+    EdgeAttributes roadAttributes;
+    std::string onewayTag;
+    bool roundabout = false;
+    int64_t wayId = -1;
+    std::vector<Segment> segments;
+
+    std::string geomType;
+    std::vector<std::pair<double, double>> coords;
+    double prevLat = 0.0;
+    double prevLon = 0.0;
+    bool havePrev = false;
+    bool featuresSeen = false;
+    std::string error;
+};
+
+} // namespace
+
+// Dispatch on the file header so callers can pass either format
+void Graph::load(const std::string& filename, NodeOrder order) {
+    if (isSnapshotFile(filename))
+        openSnapshot(filename);
+    else
+        loadFromGeoJSON(filename, order);
+}
+
+// Load GeoJSON file to build graph, streaming it through a SAX parser
+void Graph::loadFromGeoJSON(const std::string& filename, NodeOrder order) {
+    std::ifstream in(filename);
+    if (!in.is_open())
+        throw std::runtime_error("Cannot open GeoJSON file: " + filename);
+
+    pendingNodes.clear();
+    pendingEdges.clear();
+    pendingWayIds.clear();
+    coordToIndex.clear();
+
+    GeoJSONSaxHandler handler(*this);
+    if (!json::sax_parse(in, &handler))
+        throw std::runtime_error("JSON parse error: " + handler.errorMessage());
+
+    if (!handler.sawFeatures())
+        throw std::runtime_error("Invalid GeoJSON: missing 'features' array");
+
+    finalize(order);
+
     std::cout << "Loaded graph with " << nodes.size() << " nodes\n";
 }
 
@@ -97,18 +798,33 @@ void Graph::loadFromGeoJSON(const std::string& filename) {
 int Graph::findNearestNode(double lat, double lon) const {
     if (nodes.empty())
         throw std::runtime_error("findNearestNode: graph has no nodes");
+    return spatialIndex ? spatialIndex->nearest(lat, lon) : -1;
+}
 
-    int bestID = -1;
-    double bestDist = std::numeric_limits<double>::infinity();
+// Batch snapping; sorting the queries along the index would help cache reuse
+// only marginally, so they are answered in input order
+std::vector<int> Graph::findNearestNodes(const std::vector<std::pair<double, double>>& points) const {
+    if (nodes.empty())
+        throw std::runtime_error("findNearestNodes: graph has no nodes");
+    std::vector<int> ids(points.size(), -1);
+    for (size_t i = 0; spatialIndex && i < points.size(); ++i)
+        ids[i] = spatialIndex->nearest(points[i].first, points[i].second);
+    return ids;
+}
 
-    for (int i = 0; i < (int)nodes.size(); ++i) {
-        double d = haversine(lat, lon, nodes[i].lat, nodes[i].lon);
-        if (d < bestDist) {
-            bestDist = d;
-            bestID = i;
-        }
-    }
-    return bestID;
+int Graph::findNearestUsableNode(double lat, double lon) const {
+    if (nodes.empty())
+        throw std::runtime_error("findNearestUsableNode: graph has no nodes");
+    return spatialIndex ? spatialIndex->nearest(lat, lon, usableNodes.data()) : -1;
+}
+
+std::vector<int> Graph::findNearestUsableNodes(const std::vector<std::pair<double, double>>& points) const {
+    if (nodes.empty())
+        throw std::runtime_error("findNearestUsableNodes: graph has no nodes");
+    std::vector<int> ids(points.size(), -1);
+    for (size_t i = 0; spatialIndex && i < points.size(); ++i)
+        ids[i] = spatialIndex->nearest(points[i].first, points[i].second, usableNodes.data());
+    return ids;
 }
 
 double Graph::getLat(int index) const {
@@ -0,0 +1,263 @@
+// isochrone.cpp
+#include "isochrone.hpp"
+#include "search_workspace.hpp"
+#include "search_kernels.hpp"
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+#include <utility>
+
+namespace
+{
+
+constexpr double METRES_PER_DEGREE = Graph::EARTH_RADIUS * M_PI / 180.0;
+
+// Grids beyond this many cells are refused rather than allocated
+constexpr size_t MAX_GRID_CELLS = 40000000;
+
+// Corner-to-corner moves, counter-clockwise from east
+constexpr int DX[4] = {1, 0, -1, 0};
+constexpr int DY[4] = {0, 1, 0, -1};
+
+// Buffers for one thread's isochrones, kept between calls
+struct IsochroneWorkspace
+{
+    ReachableSet reach;
+    std::vector<std::pair<int, int>> hits;  // grid cells touched by reachable roads
+    std::vector<char> filled;               // padded grid, row-major
+    std::vector<int> component;             // 4-connected component per filled cell
+    std::vector<int> stack;
+    std::vector<unsigned char> outMask;     // boundary directions leaving each corner
+    std::vector<unsigned char> usedMask;
+    std::vector<std::pair<int, int>> corners;
+
+    static IsochroneWorkspace &local()
+    {
+        thread_local IsochroneWorkspace workspace;
+        return workspace;
+    }
+};
+
+// Boundary edge after arriving at a corner heading d. Preferring the left
+// turn keeps cells that only touch diagonally on separate rings, and makes
+// the choice a function of the incoming edge alone, so rings never cross.
+int nextDirection(unsigned char mask, int d)
+{
+    for (int turn : {1, 0, 3})
+    {
+        int nd = (d + turn) % 4;
+        if (mask & (1 << nd))
+            return nd;
+    }
+    return -1;
+}
+
+} // namespace
+
+void reachableWithin(const Graph &g, int src, double maxCost, ReachableSet &out)
+{
+    out.nodes.clear();
+    out.costs.clear();
+    SearchSpace &space = SearchWorkspace::local().forward;
+    SpaceHeap heap{space};
+    WithinCost target{space, (Distance)(maxCost * WEIGHT_SCALE), out.nodes};
+    out.nodesVisited = searchKernel(g, space, heap, src, NoHeuristic{}, NoBlocking{}, target);
+    for (int u : out.nodes)
+        out.costs.push_back(Graph::toCost(space.dist(u)));
+}
+
+std::vector<Isochrone> buildIsochrones(const Graph &g, int src, const std::vector<double> &maxCosts,
+                                       double cellMetres)
+{
+    if (!(cellMetres > 0.0))
+        throw std::runtime_error("buildIsochrones: cell size must be positive");
+
+    std::vector<Isochrone> result(maxCosts.size());
+    if (maxCosts.empty())
+        return result;
+
+    IsochroneWorkspace &ws = IsochroneWorkspace::local();
+    reachableWithin(g, src, *std::max_element(maxCosts.begin(), maxCosts.end()), ws.reach);
+
+    // Equirectangular metres around the source; exact enough at city scale
+    const double lat0 = g.nodes[src].lat;
+    const double lon0 = g.nodes[src].lon;
+    const double metresPerLonDegree = METRES_PER_DEGREE * std::cos(lat0 * M_PI / 180.0);
+    auto project = [&](int u)
+    {
+        return std::make_pair((g.nodes[u].lon - lon0) * metresPerLonDegree,
+                              (g.nodes[u].lat - lat0) * METRES_PER_DEGREE);
+    };
+    auto cellOf = [&](double x, double y)
+    {
+        return std::make_pair((int)std::floor(x / cellMetres), (int)std::floor(y / cellMetres));
+    };
+
+    for (size_t k = 0; k < maxCosts.size(); ++k)
+    {
+        Isochrone &iso = result[k];
+        iso.maxCost = maxCosts[k];
+        const int count = (int)(std::upper_bound(ws.reach.costs.begin(), ws.reach.costs.end(), maxCosts[k]) -
+                                ws.reach.costs.begin());
+        iso.reachableNodes = count;
+        if (count == 0)
+            continue;
+
+        // Sample every reachable node and the reachable stretch of its
+        // outgoing roads at half-cell spacing
+        ws.hits.clear();
+        for (int i = 0; i < count; ++i)
+        {
+            int u = ws.reach.nodes[i];
+            double slack = maxCosts[k] - ws.reach.costs[i];
+            auto [ux, uy] = project(u);
+            ws.hits.push_back(cellOf(ux, uy));
+            for (int e = g.edgeBegin(u); e < g.edgeEnd(u); ++e)
+            {
+                EdgeWeight w = g.edgeWeight(e);
+                if (!isPassable(w))
+                    continue;
+                double cost = Graph::toCost(w);
+                double reach = cost > slack ? slack / cost : 1.0;
+                auto [vx, vy] = project(g.edgeTarget(e));
+                double length = std::hypot(vx - ux, vy - uy) * reach;
+                int steps = (int)std::ceil(length / (0.5 * cellMetres));
+                for (int s = 1; s <= steps; ++s)
+                {
+                    double t = reach * s / steps;
+                    ws.hits.push_back(cellOf(ux + (vx - ux) * t, uy + (vy - uy) * t));
+                }
+            }
+        }
+
+        int minX = ws.hits[0].first, maxX = minX, minY = ws.hits[0].second, maxY = minY;
+        for (auto [x, y] : ws.hits)
+        {
+            minX = std::min(minX, x);
+            maxX = std::max(maxX, x);
+            minY = std::min(minY, y);
+            maxY = std::max(maxY, y);
+        }
+        // One empty cell of padding on every side keeps lookups in range
+        const int w = maxX - minX + 3;
+        const int h = maxY - minY + 3;
+        if ((size_t)(w + 1) * (h + 1) > MAX_GRID_CELLS)
+            throw std::runtime_error("buildIsochrones: grid too large for this cell size");
+        ws.filled.assign((size_t)w * h, 0);
+        for (auto [x, y] : ws.hits)
+            ws.filled[(size_t)(y - minY + 1) * w + (x - minX + 1)] = 1;
+        auto isFilled = [&](int x, int y)
+        { return ws.filled[(size_t)y * w + x] != 0; };
+
+        // Label 4-connected components; each becomes one polygon
+        ws.component.assign((size_t)w * h, -1);
+        int components = 0;
+        for (size_t c = 0; c < ws.filled.size(); ++c)
+        {
+            if (!ws.filled[c] || ws.component[c] != -1)
+                continue;
+            ws.component[c] = components;
+            ws.stack.assign(1, (int)c);
+            while (!ws.stack.empty())
+            {
+                int cur = ws.stack.back();
+                ws.stack.pop_back();
+                for (int d = 0; d < 4; ++d)
+                {
+                    int next = cur + DX[d] + DY[d] * w;
+                    if (ws.filled[next] && ws.component[next] == -1)
+                    {
+                        ws.component[next] = components;
+                        ws.stack.push_back(next);
+                    }
+                }
+            }
+            ++components;
+        }
+
+        // Boundary edges run with the filled cell on their left, so outer
+        // rings come out counter-clockwise and holes clockwise
+        const int cw = w + 1;
+        ws.outMask.assign((size_t)cw * (h + 1), 0);
+        ws.usedMask.assign(ws.outMask.size(), 0);
+        for (int y = 1; y < h - 1; ++y)
+        {
+            for (int x = 1; x < w - 1; ++x)
+            {
+                if (!isFilled(x, y))
+                    continue;
+                if (!isFilled(x, y - 1))
+                    ws.outMask[(size_t)y * cw + x] |= 1 << 0;
+                if (!isFilled(x + 1, y))
+                    ws.outMask[(size_t)y * cw + x + 1] |= 1 << 1;
+                if (!isFilled(x, y + 1))
+                    ws.outMask[(size_t)(y + 1) * cw + x + 1] |= 1 << 2;
+                if (!isFilled(x - 1, y))
+                    ws.outMask[(size_t)(y + 1) * cw + x] |= 1 << 3;
+            }
+        }
+
+        auto toNode = [&](int x, int y)
+        {
+            double mx = (double)(x - 1 + minX) * cellMetres;
+            double my = (double)(y - 1 + minY) * cellMetres;
+            return Node{lat0 + my / METRES_PER_DEGREE, lon0 + mx / metresPerLonDegree};
+        };
+        // Cell on the left of the edge leaving corner (x, y) heading d
+        auto leftCell = [&](int x, int y, int d)
+        {
+            static constexpr int LX[4] = {0, -1, -1, 0};
+            static constexpr int LY[4] = {0, 0, -1, -1};
+            return (size_t)(y + LY[d]) * w + (x + LX[d]);
+        };
+
+        std::vector<int> polygonOf(components, -1);
+        std::vector<std::pair<int, Ring>> holes;
+        for (size_t v0 = 0; v0 < ws.outMask.size(); ++v0)
+        {
+            for (int d0 = 0; d0 < 4; ++d0)
+            {
+                if (!(ws.outMask[v0] & ~ws.usedMask[v0] & (1 << d0)))
+                    continue;
+
+                // Follow the boundary until the starting edge comes round
+                // again, keeping only the corners where it turns
+                ws.corners.clear();
+                int x = (int)(v0 % cw), y = (int)(v0 / cw), d = d0;
+                double area2 = 0.0;
+                do
+                {
+                    ws.usedMask[(size_t)y * cw + x] |= 1 << d;
+                    int nx = x + DX[d], ny = y + DY[d];
+                    area2 += (double)x * ny - (double)nx * y;
+                    int nd = nextDirection(ws.outMask[(size_t)ny * cw + nx], d);
+                    if (nd != d)
+                        ws.corners.emplace_back(nx, ny);
+                    x = nx;
+                    y = ny;
+                    d = nd;
+                } while (!((size_t)y * cw + x == v0 && d == d0));
+
+                Ring ring;
+                ring.reserve(ws.corners.size() + 1);
+                for (auto [cx, cy] : ws.corners)
+                    ring.push_back(toNode(cx, cy));
+                ring.push_back(ring.front());
+
+                int comp = ws.component[leftCell((int)(v0 % cw), (int)(v0 / cw), d0)];
+                if (area2 > 0.0)
+                {
+                    polygonOf[comp] = (int)iso.polygons.size();
+                    iso.polygons.push_back({std::move(ring), {}});
+                }
+                else
+                {
+                    holes.emplace_back(comp, std::move(ring));
+                }
+            }
+        }
+        for (auto &[comp, ring] : holes)
+            iso.polygons[polygonOf[comp]].holes.push_back(std::move(ring));
+    }
+    return result;
+}
@@ -0,0 +1,165 @@
+// landmarks.cpp
+#include "landmarks.hpp"
+#include "graph.hpp"
+#include "search_workspace.hpp"
+#include "thread_pool.hpp"
+#include <chrono>
+#include <iostream>
+#include <limits>
+#include <numeric>
+
+namespace
+{
+
+// Dijkstra from every root at once over forward edges, or over reverse
+// edges to get distances towards the roots. Unreached nodes get infinity.
+void shortestDistances(const Graph &g, const std::vector<int> &roots, bool reverse, std::vector<double> &out)
+{
+    const int n = g.numNodes();
+    SearchSpace &space = SearchWorkspace::local().forward;
+    space.reset(n);
+    for (int r : roots)
+    {
+        space.update(r, 0.0, 0.0, -1);
+        space.push(0.0, r);
+    }
+
+    while (!space.empty())
+    {
+        auto [key, u] = space.pop();
+        if (key > space.key(u))
+            continue;
+        Distance d = space.dist(u);
+
+        auto relax = [&](int v, EdgeWeight weight)
+        {
+            if (!isPassable(weight))
+                return;
+            Distance nd = d + weight;
+            if (nd < space.dist(v))
+            {
+                space.update(v, nd, nd, u);
+                space.push(nd, v);
+            }
+        };
+        if (reverse)
+        {
+            for (int r = g.reverseBegin(u), end = g.reverseEnd(u); r < end; ++r)
+                relax(g.reverseSource(r), g.edgeWeight(g.reverseEdge(r)));
+        }
+        else
+        {
+            for (int e = g.edgeBegin(u), end = g.edgeEnd(u); e < end; ++e)
+                relax(g.edgeTarget(e), g.edgeWeight(e));
+        }
+    }
+
+    out.resize(n);
+    for (int v = 0; v < n; ++v)
+        out[v] = space.reached(v) ? (double)space.dist(v) : std::numeric_limits<double>::infinity();
+}
+
+// Node farthest from the roots; unreached nodes (another component) win.
+// Nodes the weights close off entirely, such as footway nodes for cars, are
+// never picked: distances through them are all infinite.
+int farthestNode(const std::vector<double> &dist, const std::vector<char> &usable)
+{
+    int best = -1;
+    double bestDist = 0.0;
+    for (int v = 0; v < (int)dist.size(); ++v)
+    {
+        if (usable[v] && dist[v] > bestDist)
+        {
+            bestDist = dist[v];
+            best = v;
+        }
+    }
+    return best;
+}
+
+} // namespace
+
+void Landmarks::build(const Graph &g, int count)
+{
+    auto t0 = std::chrono::steady_clock::now();
+    const int n = g.numNodes();
+    landmarks.clear();
+    fromLandmark.clear();
+    toLandmark.clear();
+    stride = 0;
+    slack = 0.0;
+    if (n == 0 || count <= 0)
+        return;
+
+    std::vector<char> usable(n, 0);
+    for (int u = 0; u < n; ++u)
+        for (int e = g.edgeBegin(u); e < g.edgeEnd(u); ++e)
+            if (isPassable(g.edgeWeight(e)))
+                usable[u] = usable[g.edgeTarget(e)] = 1;
+
+    // Farthest selection: start at the node farthest from node 0, then keep
+    // adding the node farthest from every landmark chosen so far
+    std::vector<double> dist;
+    shortestDistances(g, {0}, false, dist);
+    int next = farthestNode(dist, usable);
+    landmarks.push_back(next == -1 ? 0 : next);
+    while ((int)landmarks.size() < count)
+    {
+        shortestDistances(g, landmarks, false, dist);
+        next = farthestNode(dist, usable);
+        if (next == -1)
+            break;
+        landmarks.push_back(next);
+    }
+
+    stride = (int)landmarks.size();
+    const float INF = std::numeric_limits<float>::infinity();
+    fromLandmark.assign((size_t)n * stride, INF);
+    toLandmark.assign((size_t)n * stride, INF);
+
+    // One forward and one reverse search per landmark, each writing its own column
+    ThreadPool::shared().parallelFor(2 * (size_t)stride, [&](size_t task)
+                                     {
+        int l = (int)(task / 2);
+        bool reverse = task % 2 == 1;
+        std::vector<double> column;
+        shortestDistances(g, {landmarks[l]}, reverse, column);
+        std::vector<float> &table = reverse ? toLandmark : fromLandmark;
+        for (int v = 0; v < n; ++v)
+            table[(size_t)v * stride + l] = (float)column[v]; });
+
+    // Each stored float is within 2^-24 (relative) of the exact distance;
+    // a bound subtracts two of them, so 2^-22 of the largest covers it
+    double maxDist = 0.0;
+    for (const auto *table : {&fromLandmark, &toLandmark})
+        for (float d : *table)
+            if (std::isfinite(d))
+                maxDist = std::max(maxDist, (double)d);
+    slack = std::ldexp(maxDist, -22);
+
+    auto t1 = std::chrono::steady_clock::now();
+    std::cout << "Built " << stride << " landmarks in "
+              << std::chrono::duration<double, std::milli>(t1 - t0).count() << " ms\n";
+}
+
+bool Landmarks::matches(const Graph &g) const
+{
+    return stride > 0 && fromLandmark.size() == (size_t)g.numNodes() * stride;
+}
+
+std::vector<int> Landmarks::select(int src, int dest, int count) const
+{
+    std::vector<int> all(stride);
+    std::iota(all.begin(), all.end(), 0);
+    if (count <= 0 || count >= stride)
+        return all;
+
+    std::vector<double> bound(stride);
+    for (int l = 0; l < stride; ++l)
+        bound[l] = lowerBound(src, dest, {l});
+    std::partial_sort(all.begin(), all.begin() + count, all.end(),
+                      [&](int a, int b)
+                      { return bound[a] > bound[b]; });
+    all.resize(count);
+    return all;
+}
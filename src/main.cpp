@@ -4,8 +4,19 @@
 #include <fstream>
 #include <string>
 #include <iostream>
+#include <algorithm>
+#include <cstdlib>
+#include <memory>
 #include "graph.hpp"
 #include "algorithms.hpp"
+#include "yen.hpp"
+#include "ch.hpp"
+#include "landmarks.hpp"
+#include "connectivity.hpp"
+#include "compact_graph.hpp"
+#include "matrix.hpp"
+#include "isochrone.hpp"
+#include "thread_pool.hpp"
 #include "json.hpp"
 
 #ifdef __EMSCRIPTEN__
@@ -16,6 +27,33 @@
 #endif
 
 static Graph g;
+static std::unique_ptr<DynamicCriticalPoints> closures;
+
+// Everything one cost profile routes on: a weight view of g and the
+// preprocessing built over it, each made on first use. Compact graphs share
+// the car profile's chains and junctions.
+struct ProfileRouting
+{
+    Graph graph;
+    CompactGraph compact;
+    ContractionHierarchy ch;
+    Landmarks landmarks;
+};
+static ProfileRouting profiles[PROFILE_COUNT];
+
+static ProfileRouting &routing(Profile profile)
+{
+    ProfileRouting &r = profiles[(int)profile];
+    if (r.graph.numNodes() != g.numNodes())
+    {
+        r.graph = g.withProfile(profile);
+        if (profile == Profile::Car)
+            r.compact.build(r.graph);
+        else
+            r.compact = routing(Profile::Car).compact.withProfile(r.graph);
+    }
+    return r;
+}
 using json = nlohmann::json;
 
 static size_t getCurrentRSSKB()
@@ -37,58 +75,159 @@ static size_t getCurrentRSSKB()
     return 0;
 }
 
-extern "C"
+// Arguments of one findKShortestRoutes call
+struct RouteRequest
 {
+    double lat1;
+    double lon1;
+    double lat2;
+    double lon2;
+    int algorithm;
+    int k;
+    double maxDetourRatio;
+    double timeBudgetMS;
+    int profile;
+};
 
-    // Load graph from GeoJSON path (Emscripten will read it from preloaded FS)
-    EXPORTED
-    void initgraph(const char *filename)
+// A profile's routing with whatever the algorithm needs built. Builds are
+// not thread-safe, so batches prepare every request before fanning out.
+static ProfileRouting &prepareRouting(int profile, int algorithm)
+{
+    ProfileRouting &r = routing((Profile)profile);
+    if (algorithm == 4 && r.ch.empty())
+        r.ch.build(r.graph);
+    if (algorithm == 5 && r.landmarks.empty())
+        r.landmarks.build(r.graph);
+    return r;
+}
+
+// findKShortestRoutes' result document, or null for an invalid request;
+// threads goes to YenOptions::threads
+static json shortestRoutes(const RouteRequest &q, int threads)
+{
+    if (q.profile < 0 || q.profile >= PROFILE_COUNT)
     {
-        g.loadFromGeoJSON(filename);
+        std::cerr << "Invalid profile " << q.profile << ".\n";
+        return json();
     }
+    ProfileRouting &r = prepareRouting(q.profile, q.algorithm);
 
-    // Find shortest route and return JSON string
-    EXPORTED
+    // Snap to roads the profile may use
+    int startId = r.graph.findNearestUsableNode(q.lat1, q.lon1);
+    int endId = r.graph.findNearestUsableNode(q.lat2, q.lon2);
+    if (startId < 0 || endId < 0)
+    {
+        std::cerr << "Invalid start or end node.\n";
+        return json();
+    }
 
-    EXPORTED
-    char *findKShortestRoutes(double lat1, double lon1, double lat2, double lon2, int astar)
+    auto start = std::chrono::high_resolution_clock::now();
+    KPathsResult kPaths;
+    if (q.algorithm == 4)
+    {
+        auto queryStart = std::chrono::high_resolution_clock::now();
+        PathResult route = r.ch.query(startId, endId);
+        route.timeMS = std::chrono::duration<double, std::milli>(
+                           std::chrono::high_resolution_clock::now() - queryStart)
+                           .count();
+        if (!route.path.empty())
+            kPaths.paths.push_back(std::move(route));
+    }
+    else
     {
-        int startId = g.findNearestNode(lat1, lon1);
-        int endId = g.findNearestNode(lat2, lon2);
+        YenOptions options;
+        if (q.k > 0)
+            options.k = q.k;
+        options.maxDetourRatio = q.maxDetourRatio;
+        options.timeBudgetMS = q.timeBudgetMS;
+        options.threads = threads;
 
-        if (startId < 0 || endId < 0)
+        // Each engine gets its own Yen instantiation, searching the
+        // compact graph; routes unpack to the full graph's nodes
+        CompactQuery query = r.compact.prepare(r.graph, startId, endId);
+        auto runYen = [&](const auto &kernel)
         {
-            std::cerr << "Invalid start or end node.\n";
-            return nullptr;
+            kPaths = yenKShortestPaths(query.graph(), query.src(), query.dest(), kernel, options);
+            for (PathResult &route : kPaths.paths)
+                query.unpack(r.graph, route);
+        };
+        switch (q.algorithm)
+        {
+        case 1:
+            runYen(AstarKernel{});
+            break;
+        case 2:
+            runYen(BidirectionalDijkstraKernel{});
+            break;
+        case 3:
+            runYen(BidirectionalAstarKernel{});
+            break;
+        case 5:
+            // Landmark tables cover the full graph's nodes only
+            kPaths = yenKShortestPaths(r.graph, startId, endId, AltKernel{&r.landmarks}, options);
+            break;
+        default:
+            runYen(DijkstraKernel{});
         }
+    }
+    auto end = std::chrono::high_resolution_clock::now();
+    double execTime = std::chrono::duration<double, std::milli>(end - start).count();
 
-        ShortestPathFunc ShortestPathFunc = (astar) ? astarWithBlock : dijkstraWithBlock;
-
-        auto start = std::chrono::high_resolution_clock::now();
-        KPathsResult kPaths = yenKShortestPaths(g, startId, endId, ShortestPathFunc);
-        auto end = std::chrono::high_resolution_clock::now();
-        double execTime = std::chrono::duration<double, std::milli>(end - start).count();
-
-        json output;
-        output["executionTime"] = execTime;
-        output["memoryUsage"] = getCurrentRSSKB(); // You can define this function using OS-specific tools.
+    json output;
+    output["executionTime"] = execTime;
+    output["memoryUsage"] = getCurrentRSSKB(); // You can define this function using OS-specific tools.
 
-        output["yenKShortestPaths"] = json::array();
+    output["yenKShortestPaths"] = json::array();
 
-        for (const auto &path : kPaths.paths)
+    for (const auto &path : kPaths.paths)
+    {
+        json coordinates = json::array();
+        for (int nodeId : path.path)
         {
-            json coordinates = json::array();
-            for (int nodeId : path.path)
-            {
-                coordinates.push_back({g.nodes[nodeId].lat, g.nodes[nodeId].lon});
-            }
-            output["yenKShortestPaths"].push_back({{"coordinates", coordinates},
-                                                   {"distance", path.length},
-                                                   {"nodesVisited", path.nodeVisited},
-                                                   {"timeMS", path.timeMS}, 
-                                                   {"memoryUsage", path.memoryUsage}});
+            coordinates.push_back({g.nodes[nodeId].lat, g.nodes[nodeId].lon});
         }
+        output["yenKShortestPaths"].push_back({{"coordinates", coordinates},
+                                               {"distance", g.pathMetres(path.path)},
+                                               {"cost", path.length},
+                                               {"nodesVisited", path.nodeVisited},
+                                               {"timeMS", path.timeMS}, 
+                                               {"memoryUsage", path.memoryUsage}});
+    }
+
+    return output;
+}
+
+extern "C"
+{
+
+    // Load graph from a GeoJSON or snapshot path (Emscripten will read it from preloaded FS)
+    EXPORTED
+    void initgraph(const char *filename)
+    {
+        g.load(filename);
+        for (ProfileRouting &r : profiles)
+            r = ProfileRouting();
+        routing(Profile::Car);
+        closures.reset();
+    }
 
+    // Find shortest route and return JSON string
+    EXPORTED
+
+    EXPORTED
+    // algorithm: 0 = Dijkstra, 1 = A*, 2 = bidirectional Dijkstra, 3 = bidirectional A*,
+    // 4 = contraction hierarchy (single shortest route, built on first use),
+    // 5 = ALT A* (landmarks built on first use)
+    // k <= 0 means the default of four routes; maxDetourRatio and timeBudgetMS
+    // are ignored when <= 0. profile: 0 = car, 1 = distance, 2 = two-wheeler,
+    // 3 = walking (see Profile). Each route reports "distance" in metres and
+    // "cost" in the profile's units: seconds, or metres for distance.
+    char *findKShortestRoutes(double lat1, double lon1, double lat2, double lon2, int astar,
+                              int k, double maxDetourRatio, double timeBudgetMS, int profile)
+    {
+        json output = shortestRoutes({lat1, lon1, lat2, lon2, astar, k, maxDetourRatio, timeBudgetMS, profile}, 0);
+        if (output.is_null())
+            return nullptr;
         std::string *resultStr = new std::string(output.dump());
         return (char *)resultStr->c_str();
     }
@@ -97,7 +236,7 @@ extern "C"
     EXPORTED
     char *criticalpoints()
     {
-        PathResult cp = findCriticalPoints(g);
+        PathResult cp = findCriticalPoints(g, 0);
         json doc;
 
         json cp_coords = json::array();
@@ -111,13 +250,404 @@ extern "C"
         std::string *result_str = new std::string(doc.dump());
         return (char *)result_str->c_str();
     }
+
+    // Articulation points, bridges, biconnected components and the block-cut
+    // tree. Components list their segments once each; blockCutTree pairs a
+    // component index with an index into articulationPoints.
+    EXPORTED
+    char *biconnectedcomponents()
+    {
+        BiconnectivityResult bc = findBiconnectedComponents(g);
+        auto coords = [](int id)
+        { return json::array({g.nodes[id].lat, g.nodes[id].lon}); };
+
+        json points = json::array();
+        for (int id : bc.articulationPoints)
+            points.push_back(coords(id));
+
+        std::vector<char> isBridge(g.numEdges(), 0);
+        for (int e : bc.bridges)
+            isBridge[e] = 1;
+
+        // Walk edges by source node; other segments are listed from their lower id
+        json bridges = json::array();
+        json components(bc.numComponents, json::array());
+        for (int u = 0; u < g.numNodes(); ++u)
+        {
+            for (int e = g.edgeBegin(u); e < g.edgeEnd(u); ++e)
+            {
+                int v = g.edgeTarget(e);
+                if (isBridge[e])
+                    bridges.push_back({coords(u), coords(v)});
+                if (u < v && bc.edgeComponent[e] != -1)
+                    components[bc.edgeComponent[e]].push_back({coords(u), coords(v)});
+            }
+        }
+
+        json tree = json::array();
+        for (const auto &[block, node] : bc.blockCutEdges)
+        {
+            auto it = std::lower_bound(bc.articulationPoints.begin(), bc.articulationPoints.end(), node);
+            tree.push_back({block, it - bc.articulationPoints.begin()});
+        }
+
+        json doc;
+        doc["biconnected"] = {
+            {"articulationPoints", points},
+            {"bridges", bridges},
+            {"components", components},
+            {"blockCutTree", tree},
+            {"executionTime", bc.timeMS}};
+
+        std::string *result_str = new std::string(doc.dump());
+        return (char *)result_str->c_str();
+    }
+}
+
+// Close or reopen every segment between the nodes nearest to the two points
+// and report what changed, as JSON
+static char *updateClosure(double lat1, double lon1, double lat2, double lon2, bool close)
+{
+    int u = g.findNearestNode(lat1, lon1);
+    int v = g.findNearestNode(lat2, lon2);
+    if (u < 0 || v < 0)
+        return nullptr;
+    if (!closures)
+        closures = std::make_unique<DynamicCriticalPoints>(g);
+
+    auto start = std::chrono::high_resolution_clock::now();
+    ClosureUpdate total;
+    for (int e = g.edgeBegin(u); e < g.edgeEnd(u); ++e)
+    {
+        if (g.edgeTarget(e) != v)
+            continue;
+        ClosureUpdate step = close ? closures->closeEdge(e) : closures->reopenEdge(e);
+        auto append = [](std::vector<int> &to, const std::vector<int> &from)
+        { to.insert(to.end(), from.begin(), from.end()); };
+        append(total.newlyCritical, step.newlyCritical);
+        append(total.noLongerCritical, step.noLongerCritical);
+        append(total.newBridges, step.newBridges);
+        append(total.removedBridges, step.removedBridges);
+        total.nodesVisited += step.nodesVisited;
+    }
+    double execTime = std::chrono::duration<double, std::milli>(
+                          std::chrono::high_resolution_clock::now() - start)
+                          .count();
+
+    auto points = [](const std::vector<int> &ids)
+    {
+        json out = json::array();
+        for (int id : ids)
+            out.push_back({g.nodes[id].lat, g.nodes[id].lon});
+        return out;
+    };
+    auto segments = [](const std::vector<int> &edges)
+    {
+        json out = json::array();
+        for (int e : edges)
+        {
+            // The tail is the reverse entry of e at its head
+            int v = g.edgeTarget(e);
+            for (int r = g.reverseBegin(v); r < g.reverseEnd(v); ++r)
+            {
+                if (g.reverseEdge(r) != e)
+                    continue;
+                int u = g.reverseSource(r);
+                out.push_back({{g.nodes[u].lat, g.nodes[u].lon}, {g.nodes[v].lat, g.nodes[v].lon}});
+                break;
+            }
+        }
+        return out;
+    };
+
+    json doc;
+    doc["closure"] = {
+        {"newlyCritical", points(total.newlyCritical)},
+        {"noLongerCritical", points(total.noLongerCritical)},
+        {"newBridges", segments(total.newBridges)},
+        {"removedBridges", segments(total.removedBridges)},
+        {"nodesVisited", total.nodesVisited},
+        {"executionTime", execTime}};
+
+    std::string *result_str = new std::string(doc.dump());
+    return (char *)result_str->c_str();
 }
-int main()
+
+extern "C"
+{
+    // Road closures for the live dashboard. The first call builds the
+    // tracker; later ones only touch the area around the segment.
+    EXPORTED
+    char *closeroad(double lat1, double lon1, double lat2, double lon2)
+    {
+        return updateClosure(lat1, lon1, lat2, lon2, true);
+    }
+
+    EXPORTED
+    char *reopenroad(double lat1, double lon1, double lat2, double lon2)
+    {
+        return updateClosure(lat1, lon1, lat2, lon2, false);
+    }
+}
+
+// Cost matrix for a request {"sources": [[lat, lon], ...], "targets": [...],
+// "profile": 0}; profile is optional and numbered as in findKShortestRoutes.
+// Points snap to the nearest node the profile may use; costs[i][j] is null
+// where target j cannot be reached from source i.
+static json distanceMatrix(const json &request)
+{
+    int profile = request.value("profile", (int)Profile::Car);
+    if (profile < 0 || profile >= PROFILE_COUNT)
+        throw std::runtime_error("Invalid profile " + std::to_string(profile));
+    const Graph &pg = routing((Profile)profile).graph;
+    auto snap = [&](const json &points)
+    {
+        std::vector<std::pair<double, double>> latLon;
+        for (const auto &p : points)
+            latLon.emplace_back(p.at(0).get<double>(), p.at(1).get<double>());
+        std::vector<int> ids = pg.findNearestUsableNodes(latLon);
+        if (std::find(ids.begin(), ids.end(), -1) != ids.end())
+            throw std::runtime_error("No road usable by the profile to snap to");
+        return ids;
+    };
+
+    auto start = std::chrono::high_resolution_clock::now();
+    std::vector<int> sources = snap(request.at("sources"));
+    std::vector<int> targets = snap(request.at("targets"));
+    CostMatrix m = costMatrix(pg, sources, targets);
+    double execTime = std::chrono::duration<double, std::milli>(
+                          std::chrono::high_resolution_clock::now() - start)
+                          .count();
+
+    auto points = [](const std::vector<int> &ids)
+    {
+        json out = json::array();
+        for (int id : ids)
+            out.push_back({g.nodes[id].lat, g.nodes[id].lon});
+        return out;
+    };
+    json costs = json::array();
+    for (int i = 0; i < m.sources; ++i)
+    {
+        json row = json::array();
+        for (int j = 0; j < m.targets; ++j)
+        {
+            double c = m.at(i, j);
+            if (c == CostMatrix::UNREACHABLE)
+                row.push_back(nullptr);
+            else
+                row.push_back(c);
+        }
+        costs.push_back(std::move(row));
+    }
+
+    json doc;
+    doc["sources"] = points(sources);
+    doc["targets"] = points(targets);
+    doc["costs"] = std::move(costs);
+    doc["nodesVisited"] = m.nodesVisited;
+    doc["executionTime"] = execTime;
+    return doc;
+}
+
+// Routes for a batch {"queries": [{"from": [lat, lon], "to": [lat, lon],
+// "algorithm": 0, "k": 0, "maxDetourRatio": 0, "timeBudgetMS": 0,
+// "profile": 0}, ...], "threads": 0}, or a bare array of queries. Everything
+// but from and to is optional, defaulting and numbered as in
+// findKShortestRoutes. Queries run in parallel on up to `threads` threads of
+// the shared pool (0 = all), each single-threaded on its thread's workspace;
+// results[i] answers queries[i], null where the query is invalid.
+static json batchRoutes(const json &request)
+{
+    const json &list = request.is_array() ? request : request.at("queries");
+    int threads = request.is_object() ? request.value("threads", 0) : 0;
+
+    std::vector<RouteRequest> queries;
+    for (const auto &q : list)
+    {
+        const json &from = q.at("from");
+        const json &to = q.at("to");
+        queries.push_back({from.at(0).get<double>(), from.at(1).get<double>(),
+                           to.at(0).get<double>(), to.at(1).get<double>(),
+                           q.value("algorithm", 0), q.value("k", 0),
+                           q.value("maxDetourRatio", 0.0), q.value("timeBudgetMS", 0.0),
+                           q.value("profile", (int)Profile::Car)});
+    }
+
+    auto start = std::chrono::high_resolution_clock::now();
+    for (const RouteRequest &q : queries)
+        if (q.profile >= 0 && q.profile < PROFILE_COUNT)
+            prepareRouting(q.profile, q.algorithm);
+    std::vector<json> results(queries.size());
+    ThreadPool::shared().parallelFor(queries.size(), [&](size_t i)
+                                     { results[i] = shortestRoutes(queries[i], 1); }, (unsigned)std::max(threads, 0));
+    double execTime = std::chrono::duration<double, std::milli>(
+                          std::chrono::high_resolution_clock::now() - start)
+                          .count();
+
+    json doc;
+    doc["results"] = std::move(results);
+    doc["executionTime"] = execTime;
+    return doc;
+}
+
+// GeoJSON FeatureCollection of `bands` isochrones around the profile-usable
+// node nearest (lat, lon), at maxCost / bands, 2 * maxCost / bands, ... maxCost,
+// each a MultiPolygon feature with its maxCost and reachable node count
+static json isochroneGeoJSON(double lat, double lon, double maxCost, int bands, double cellMetres, int profile)
+{
+    if (profile < 0 || profile >= PROFILE_COUNT)
+        throw std::runtime_error("Invalid profile " + std::to_string(profile));
+    if (bands <= 0)
+        bands = 1;
+    const Graph &pg = routing((Profile)profile).graph;
+    int src = pg.findNearestUsableNode(lat, lon);
+    if (src < 0)
+        throw std::runtime_error("No road usable by the profile to snap to");
+
+    auto start = std::chrono::high_resolution_clock::now();
+    std::vector<double> costs;
+    for (int i = 1; i <= bands; ++i)
+        costs.push_back(maxCost * i / bands);
+    std::vector<Isochrone> isochrones = buildIsochrones(pg, src, costs, cellMetres);
+    double execTime = std::chrono::duration<double, std::milli>(
+                          std::chrono::high_resolution_clock::now() - start)
+                          .count();
+
+    auto ring = [](const Ring &r)
+    {
+        json out = json::array();
+        for (const Node &p : r)
+            out.push_back({p.lon, p.lat});
+        return out;
+    };
+    json features = json::array();
+    for (const Isochrone &iso : isochrones)
+    {
+        json polygons = json::array();
+        for (const IsoPolygon &poly : iso.polygons)
+        {
+            json rings = json::array({ring(poly.outer)});
+            for (const Ring &hole : poly.holes)
+                rings.push_back(ring(hole));
+            polygons.push_back(std::move(rings));
+        }
+        features.push_back({{"type", "Feature"},
+                            {"properties", {{"maxCost", iso.maxCost}, {"reachableNodes", iso.reachableNodes}}},
+                            {"geometry", {{"type", "MultiPolygon"}, {"coordinates", std::move(polygons)}}}});
+    }
+
+    json doc;
+    doc["type"] = "FeatureCollection";
+    doc["features"] = std::move(features);
+    doc["executionTime"] = execTime;
+    return doc;
+}
+
+extern "C"
+{
+    // Isochrones as in isochroneGeoJSON; maxCost in the profile's units
+    // (seconds, or metres for distance), cellMetres <= 0 for the default
+    // 100 m grid
+    EXPORTED
+    char *isochrone(double lat, double lon, double maxCost, int bands, double cellMetres, int profile)
+    {
+        try
+        {
+            json doc = isochroneGeoJSON(lat, lon, maxCost, bands, cellMetres > 0.0 ? cellMetres : 100.0, profile);
+            std::string *result_str = new std::string(doc.dump());
+            return (char *)result_str->c_str();
+        }
+        catch (const std::exception &e)
+        {
+            std::cerr << "isochrone: " << e.what() << "\n";
+            return nullptr;
+        }
+    }
+
+    // All-pairs costs between snapped sources and targets; request and
+    // result as in distanceMatrix. Malformed requests return null.
+    EXPORTED
+    char *distancematrix(const char *request)
+    {
+        try
+        {
+            std::string *result_str = new std::string(distanceMatrix(json::parse(request)).dump());
+            return (char *)result_str->c_str();
+        }
+        catch (const std::exception &e)
+        {
+            std::cerr << "distancematrix: " << e.what() << "\n";
+            return nullptr;
+        }
+    }
+
+    // Many routing queries at once, for replaying request logs; request and
+    // result as in batchRoutes. Malformed requests return null.
+    EXPORTED
+    char *batchroutes(const char *request)
+    {
+        try
+        {
+            std::string *result_str = new std::string(batchRoutes(json::parse(request)).dump());
+            return (char *)result_str->c_str();
+        }
+        catch (const std::exception &e)
+        {
+            std::cerr << "batchroutes: " << e.what() << "\n";
+            return nullptr;
+        }
+    }
+}
+// Usage: main [graph.geojson | graph.snapshot] [--save-snapshot out.snapshot] [--ch graph.ch]
+//             [--profile car|distance|bike|foot] [--matrix request.json]
+//             [--isochrone maxCost] [--batch queries.json]
+// --ch loads a contraction hierarchy matching the graph, or builds and writes
+// one for the chosen profile; a file built for another profile is refused.
+// --matrix answers a distancematrix request into ./data/matrix.json, with
+// the request's profile defaulting to --profile. --isochrone writes three
+// isochrone bands up to maxCost around the route's source to
+// ./data/isochrone.geojson. --batch answers a batchroutes request into
+// ./data/batch.json.
+int main(int argc, char **argv)
 {
 #ifndef __EMSCRIPTEN__
     std::cout << "Main function is running.\n";
     // ———————————— Test parameters ————————————
     const char *geojsonFile = "./data/dehradun.geojson";
+    const char *snapshotOut = nullptr;
+    const char *chFile = nullptr;
+    const char *matrixFile = nullptr;
+    const char *batchFile = nullptr;
+    double isochroneCost = 0.0;
+    int profile = (int)Profile::Car;
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string arg = argv[i];
+        if (arg == "--save-snapshot" && i + 1 < argc)
+            snapshotOut = argv[++i];
+        else if (arg == "--ch" && i + 1 < argc)
+            chFile = argv[++i];
+        else if (arg == "--matrix" && i + 1 < argc)
+            matrixFile = argv[++i];
+        else if (arg == "--batch" && i + 1 < argc)
+            batchFile = argv[++i];
+        else if (arg == "--isochrone" && i + 1 < argc)
+            isochroneCost = std::atof(argv[++i]);
+        else if (arg == "--profile" && i + 1 < argc)
+        {
+            const std::string names[PROFILE_COUNT] = {"car", "distance", "bike", "foot"};
+            std::string name = argv[++i];
+            profile = (int)(std::find(names, names + PROFILE_COUNT, name) - names);
+            if (profile == PROFILE_COUNT)
+            {
+                std::cerr << "Unknown profile " << name << "\n";
+                return 1;
+            }
+        }
+        else
+            geojsonFile = argv[i];
+    }
 
     // ISBT Dehradun:  30.289248, , 77.997087:contentReference[oaicite:0]{index=0}
     double srcLat = 30.289248;
@@ -129,21 +659,80 @@ int main()
     double dstLon = 78.041863;
 
     std::string filename = "./data/routes.json";
-    std::ofstream outFile(filename);
     try
     {
         std::cout << "Loading graph from “" << geojsonFile << "”...\n";
         initgraph(geojsonFile);
+        if (snapshotOut)
+        {
+            g.saveSnapshot(snapshotOut);
+            std::cout << "  → Graph snapshot written to: " << snapshotOut << "\n";
+        }
+        if (chFile)
+        {
+            ProfileRouting &r = routing((Profile)profile);
+            ContractionHierarchy &ch = r.ch;
+            if (std::ifstream(chFile).good())
+            {
+                ch.load(chFile);
+                if (ch.profile() != (Profile)profile)
+                    throw std::runtime_error(std::string("Hierarchy was built for another profile: ") + chFile);
+            }
+            if (ch.empty() || !ch.matches(r.graph))
+            {
+                ch.build(r.graph);
+                ch.save(chFile);
+                std::cout << "  → Contraction hierarchy written to: " << chFile << "\n";
+            }
+        }
         std::cout << "Computing shortest paths between ("
                   << srcLat << ", " << srcLon << ") and ("
                   << dstLat << ", " << dstLon << ")...\n";
-        int uastar = 0;
-        char *str = findKShortestRoutes(srcLat, srcLon, dstLat, dstLon, uastar);
+        int uastar = chFile ? 4 : 0;
+        // Called directly rather than through findKShortestRoutes, so no
+        // exported string is left to free
+        json routes = shortestRoutes({srcLat, srcLon, dstLat, dstLon, uastar, 4, 0.0, 0.0, profile}, 0);
+        if (routes.is_null())
+        {
+            std::cerr << "Error: cannot route between these points with this profile\n";
+            return 1;
+        }
 
-        outFile << str;
+        std::ofstream outFile(filename);
+        outFile << routes.dump();
         outFile.close();
         std::cout << "  → Route JSON written to: " << filename << "\n";
 
+        if (matrixFile)
+        {
+            std::ifstream in(matrixFile);
+            if (!in.is_open())
+                throw std::runtime_error(std::string("Cannot open matrix request: ") + matrixFile);
+            json request = json::parse(in);
+            if (!request.contains("profile"))
+                request["profile"] = profile;
+            std::ofstream matrixOut("./data/matrix.json");
+            matrixOut << distanceMatrix(request).dump();
+            std::cout << "  → Distance matrix written to: ./data/matrix.json\n";
+        }
+
+        if (isochroneCost > 0.0)
+        {
+            std::ofstream isoOut("./data/isochrone.geojson");
+            isoOut << isochroneGeoJSON(srcLat, srcLon, isochroneCost, 3, 100.0, profile).dump();
+            std::cout << "  → Isochrones written to: ./data/isochrone.geojson\n";
+        }
+
+        if (batchFile)
+        {
+            std::ifstream in(batchFile);
+            if (!in.is_open())
+                throw std::runtime_error(std::string("Cannot open batch request: ") + batchFile);
+            std::ofstream batchOut("./data/batch.json");
+            batchOut << batchRoutes(json::parse(in)).dump();
+            std::cout << "  → Batch routes written to: ./data/batch.json\n";
+        }
+
         // std::cout << "Finding critical points...\n";
         // char *cpFile = criticalpoints();
         // std::cout << "  → Critical-points JSON written to: " << cpFile << "\n";
@@ -0,0 +1,54 @@
+// matrix.cpp
+#include "matrix.hpp"
+#include "graph.hpp"
+#include "search_workspace.hpp"
+#include "search_kernels.hpp"
+#include "thread_pool.hpp"
+#include <algorithm>
+
+CostMatrix costMatrix(const Graph &g, const std::vector<int> &sources, const std::vector<int> &targets,
+                      int threads)
+{
+    CostMatrix m;
+    m.sources = (int)sources.size();
+    m.targets = (int)targets.size();
+    m.costs.assign((size_t)m.sources * m.targets, CostMatrix::UNREACHABLE);
+    if (sources.empty() || targets.empty())
+        return m;
+
+    // Search from the first row of each distinct source; repeats copy it
+    std::vector<int> firstRow(g.numNodes(), -1);
+    std::vector<int> searched;
+    for (int i = 0; i < m.sources; ++i)
+    {
+        if (firstRow[sources[i]] != -1)
+            continue;
+        firstRow[sources[i]] = i;
+        searched.push_back(i);
+    }
+
+    const ManyTargets allTargets(g.numNodes(), targets);
+    std::vector<size_t> visited(searched.size());
+    ThreadPool::shared().parallelFor(searched.size(), [&](size_t task)
+                                     {
+        int row = searched[task];
+        ManyTargets target = allTargets;  // shares the flags, counts down on its own
+        SearchSpace &space = SearchWorkspace::local().forward;
+        SpaceHeap heap{space};
+        visited[task] = searchKernel(g, space, heap, sources[row], NoHeuristic{}, NoBlocking{}, target);
+
+        double *out = &m.costs[(size_t)row * m.targets];
+        for (int j = 0; j < m.targets; ++j)
+            if (space.reached(targets[j]))
+                out[j] = Graph::toCost(space.dist(targets[j])); }, (unsigned)threads);
+
+    for (int i = 0; i < m.sources; ++i)
+    {
+        int first = firstRow[sources[i]];
+        if (first != i)
+            std::copy_n(&m.costs[(size_t)first * m.targets], m.targets, &m.costs[(size_t)i * m.targets]);
+    }
+    for (size_t v : visited)
+        m.nodesVisited += v;
+    return m;
+}
@@ -0,0 +1,288 @@
+// snapshot.cpp
+#include "graph.hpp"
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// Snapshot layout: header, section table, then each section's raw array
+// starting on a SNAPSHOT_ALIGN boundary so it can be used in place.
+static constexpr char SNAPSHOT_MAGIC[8] = {'O', 'S', 'M', 'G', 'R', 'P', 'H', '\0'};
+static constexpr uint32_t SNAPSHOT_VERSION = 4;
+static constexpr uint32_t SNAPSHOT_ENDIAN_TAG = 0x01020304;
+static constexpr uint64_t SNAPSHOT_ALIGN = 64;
+
+// Edge weights are double seconds, or uint32 hundredths in builds with
+// OSM_FIXED_POINT_WEIGHTS; older snapshots wrote 0 here
+static constexpr uint32_t WEIGHT_FORMAT_DOUBLE = 0;
+static constexpr uint32_t WEIGHT_FORMAT_FIXED_POINT = 1;
+#ifdef OSM_FIXED_POINT_WEIGHTS
+static constexpr uint32_t WEIGHT_FORMAT = WEIGHT_FORMAT_FIXED_POINT;
+#else
+static constexpr uint32_t WEIGHT_FORMAT = WEIGHT_FORMAT_DOUBLE;
+#endif
+
+enum SectionId : uint32_t
+{
+    SECTION_NODES = 1,
+    SECTION_EDGE_OFFSETS = 2,
+    SECTION_EDGE_TARGETS = 3,
+    SECTION_EDGE_WEIGHTS = 4,
+    SECTION_REVERSE_OFFSETS = 5,
+    SECTION_REVERSE_SOURCES = 6,
+    SECTION_REVERSE_EDGES = 7,
+    SECTION_ORIGINAL_IDS = 8,  // since version 3
+    SECTION_EDGE_ATTRIBUTES = 9,  // since version 4
+    SECTION_EDGE_WAYS = 10,
+    SECTION_WAY_IDS = 11,
+};
+
+struct SnapshotHeader
+{
+    char magic[8];
+    uint32_t version;
+    uint32_t endianTag;
+    uint64_t numNodes;
+    uint64_t numEdges;
+    uint32_t sectionCount;
+    uint32_t weightFormat;  // WEIGHT_FORMAT_* of the edge weight section
+};
+
+struct SnapshotSection
+{
+    uint32_t id;
+    uint32_t elemSize;
+    uint64_t offset;
+    uint64_t count;
+};
+
+static_assert(sizeof(Node) == 2 * sizeof(double), "Node must be tightly packed");
+
+namespace
+{
+
+struct SectionSource
+{
+    uint32_t id;
+    uint32_t elemSize;
+    const void *data;
+    uint64_t count;
+};
+
+uint64_t alignUp(uint64_t value)
+{
+    return (value + SNAPSHOT_ALIGN - 1) / SNAPSHOT_ALIGN * SNAPSHOT_ALIGN;
+}
+
+template <typename T>
+SectionSource section(SectionId id, const Column<T> &column)
+{
+    return {id, (uint32_t)sizeof(T), column.data(), column.size()};
+}
+
+// Element count of a section whose length is not implied by the header
+uint64_t sectionCount(const SnapshotSection *table, uint32_t sectionCount, SectionId id)
+{
+    for (uint32_t i = 0; i < sectionCount; ++i)
+        if (table[i].id == id)
+            return table[i].count;
+    throw std::runtime_error("Invalid snapshot: missing section " + std::to_string(id));
+}
+
+// Locate a section and check it against the expected element size and the
+// mapped file length before handing out a pointer into the mapping
+template <typename T>
+const T *sectionData(const unsigned char *base, size_t fileSize,
+                     const SnapshotSection *table, uint32_t sectionCount,
+                     SectionId id, uint64_t expectedCount)
+{
+    for (uint32_t i = 0; i < sectionCount; ++i)
+    {
+        const SnapshotSection &s = table[i];
+        if (s.id != id)
+            continue;
+        if (s.elemSize != sizeof(T) || s.count != expectedCount ||
+            s.offset % SNAPSHOT_ALIGN != 0 || s.offset > fileSize ||
+            s.count * s.elemSize > fileSize - s.offset)
+            throw std::runtime_error("Invalid snapshot: corrupt section " + std::to_string(id));
+        return reinterpret_cast<const T *>(base + s.offset);
+    }
+    throw std::runtime_error("Invalid snapshot: missing section " + std::to_string(id));
+}
+
+} // namespace
+
+bool Graph::isSnapshotFile(const std::string &filename)
+{
+    std::ifstream in(filename, std::ios::binary);
+    char magic[sizeof(SNAPSHOT_MAGIC)] = {};
+    in.read(magic, sizeof(magic));
+    return in.gcount() == sizeof(magic) && std::memcmp(magic, SNAPSHOT_MAGIC, sizeof(magic)) == 0;
+}
+
+void Graph::saveSnapshot(const std::string &filename) const
+{
+    if (edgeOffsets.empty())
+        throw std::runtime_error("saveSnapshot: graph is not finalized");
+
+    const SectionSource sections[] = {
+        section(SECTION_NODES, nodes),
+        section(SECTION_EDGE_OFFSETS, edgeOffsets),
+        section(SECTION_EDGE_TARGETS, edgeTargets),
+        section(SECTION_EDGE_WEIGHTS, edgeWeights),
+        section(SECTION_REVERSE_OFFSETS, reverseOffsets),
+        section(SECTION_REVERSE_SOURCES, reverseSources),
+        section(SECTION_REVERSE_EDGES, reverseEdges),
+        section(SECTION_ORIGINAL_IDS, originalIds),
+        section(SECTION_EDGE_ATTRIBUTES, edgeAttrs),
+        section(SECTION_EDGE_WAYS, edgeWays),
+        section(SECTION_WAY_IDS, wayIds),
+    };
+    const uint32_t sectionCount = sizeof(sections) / sizeof(sections[0]);
+
+    SnapshotHeader header{};
+    std::memcpy(header.magic, SNAPSHOT_MAGIC, sizeof(header.magic));
+    header.version = SNAPSHOT_VERSION;
+    header.endianTag = SNAPSHOT_ENDIAN_TAG;
+    header.numNodes = nodes.size();
+    header.numEdges = edgeTargets.size();
+    header.sectionCount = sectionCount;
+    header.weightFormat = WEIGHT_FORMAT;
+
+    std::vector<SnapshotSection> table(sectionCount);
+    uint64_t offset = alignUp(sizeof(SnapshotHeader) + sectionCount * sizeof(SnapshotSection));
+    for (uint32_t i = 0; i < sectionCount; ++i)
+    {
+        table[i] = {sections[i].id, sections[i].elemSize, offset, sections[i].count};
+        offset = alignUp(offset + sections[i].count * sections[i].elemSize);
+    }
+
+    std::ofstream out(filename, std::ios::binary | std::ios::trunc);
+    if (!out.is_open())
+        throw std::runtime_error("Cannot open snapshot file for writing: " + filename);
+
+    out.write(reinterpret_cast<const char *>(&header), sizeof(header));
+    out.write(reinterpret_cast<const char *>(table.data()), sectionCount * sizeof(SnapshotSection));
+
+    static const char padding[SNAPSHOT_ALIGN] = {};
+    uint64_t written = sizeof(header) + sectionCount * sizeof(SnapshotSection);
+    for (uint32_t i = 0; i < sectionCount; ++i)
+    {
+        out.write(padding, table[i].offset - written);
+        uint64_t bytes = sections[i].count * sections[i].elemSize;
+        out.write(static_cast<const char *>(sections[i].data), bytes);
+        written = table[i].offset + bytes;
+    }
+    out.write(padding, offset - written);
+
+    if (!out)
+        throw std::runtime_error("Failed writing snapshot file: " + filename);
+}
+
+void Graph::openSnapshot(const std::string &filename)
+{
+    int fd = ::open(filename.c_str(), O_RDONLY);
+    if (fd < 0)
+        throw std::runtime_error("Cannot open snapshot file: " + filename);
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size < (off_t)sizeof(SnapshotHeader))
+    {
+        ::close(fd);
+        throw std::runtime_error("Invalid snapshot: file too small: " + filename);
+    }
+    const size_t fileSize = (size_t)st.st_size;
+
+    void *addr = mmap(nullptr, fileSize, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (addr == MAP_FAILED)
+        throw std::runtime_error("Cannot map snapshot file: " + filename);
+    std::shared_ptr<const void> region(addr, [fileSize](const void *p)
+                                       { munmap(const_cast<void *>(p), fileSize); });
+
+    const unsigned char *base = static_cast<const unsigned char *>(addr);
+    SnapshotHeader header;
+    std::memcpy(&header, base, sizeof(header));
+    if (std::memcmp(header.magic, SNAPSHOT_MAGIC, sizeof(header.magic)) != 0)
+        throw std::runtime_error("Invalid snapshot: bad magic in " + filename);
+    if (header.endianTag != SNAPSHOT_ENDIAN_TAG)
+        throw std::runtime_error("Invalid snapshot: written on a machine with different byte order");
+    if (header.version != SNAPSHOT_VERSION)
+        throw std::runtime_error("Unsupported snapshot version " + std::to_string(header.version) +
+                                 " (expected " + std::to_string(SNAPSHOT_VERSION) + ")");
+    if (header.weightFormat != WEIGHT_FORMAT)
+        throw std::runtime_error("Snapshot edge weights are " +
+                                 std::string(header.weightFormat == WEIGHT_FORMAT_FIXED_POINT ? "fixed-point" : "double") +
+                                 " but this build expects " +
+                                 (WEIGHT_FORMAT == WEIGHT_FORMAT_FIXED_POINT ? "fixed-point" : "double"));
+    if (sizeof(header) + (uint64_t)header.sectionCount * sizeof(SnapshotSection) > fileSize)
+        throw std::runtime_error("Invalid snapshot: truncated section table");
+
+    const SnapshotSection *table = reinterpret_cast<const SnapshotSection *>(base + sizeof(header));
+    const uint64_t n = header.numNodes;
+    const uint64_t m = header.numEdges;
+
+    const Node *nodeData = sectionData<Node>(base, fileSize, table, header.sectionCount, SECTION_NODES, n);
+    const int *offsetData = sectionData<int>(base, fileSize, table, header.sectionCount, SECTION_EDGE_OFFSETS, n + 1);
+    const int *targetData = sectionData<int>(base, fileSize, table, header.sectionCount, SECTION_EDGE_TARGETS, m);
+    const EdgeWeight *weightData = sectionData<EdgeWeight>(base, fileSize, table, header.sectionCount, SECTION_EDGE_WEIGHTS, m);
+    const int *revOffsetData = sectionData<int>(base, fileSize, table, header.sectionCount, SECTION_REVERSE_OFFSETS, n + 1);
+    const int *revSourceData = sectionData<int>(base, fileSize, table, header.sectionCount, SECTION_REVERSE_SOURCES, m);
+    const int *revEdgeData = sectionData<int>(base, fileSize, table, header.sectionCount, SECTION_REVERSE_EDGES, m);
+    const int *originalIdData = sectionData<int>(base, fileSize, table, header.sectionCount, SECTION_ORIGINAL_IDS, n);
+    const uint16_t *attrData = sectionData<uint16_t>(base, fileSize, table, header.sectionCount, SECTION_EDGE_ATTRIBUTES, m);
+    const uint32_t *edgeWayData = sectionData<uint32_t>(base, fileSize, table, header.sectionCount, SECTION_EDGE_WAYS, m);
+    const uint64_t wayCount = sectionCount(table, header.sectionCount, SECTION_WAY_IDS);
+    const int64_t *wayIdData = sectionData<int64_t>(base, fileSize, table, header.sectionCount, SECTION_WAY_IDS, wayCount);
+    for (uint64_t e = 0; e < m; ++e)
+        if (edgeWayData[e] >= wayCount)
+            throw std::runtime_error("Invalid snapshot: edge way out of range");
+    if (offsetData[0] != 0 || (uint64_t)offsetData[n] != m ||
+        revOffsetData[0] != 0 || (uint64_t)revOffsetData[n] != m)
+        throw std::runtime_error("Invalid snapshot: inconsistent edge offsets");
+    // Searches index straight into these arrays, so every id must be in range
+    for (uint64_t i = 0; i < n; ++i)
+        if (offsetData[i] > offsetData[i + 1] || revOffsetData[i] > revOffsetData[i + 1])
+            throw std::runtime_error("Invalid snapshot: inconsistent edge offsets");
+    for (uint64_t e = 0; e < m; ++e)
+    {
+        if (targetData[e] < 0 || (uint64_t)targetData[e] >= n ||
+            revSourceData[e] < 0 || (uint64_t)revSourceData[e] >= n ||
+            revEdgeData[e] < 0 || (uint64_t)revEdgeData[e] >= m)
+            throw std::runtime_error("Invalid snapshot: edge endpoint out of range");
+    }
+    std::vector<char> seen(n, 0);
+    for (uint64_t i = 0; i < n; ++i)
+    {
+        int id = originalIdData[i];
+        if (id < 0 || (uint64_t)id >= n || seen[id])
+            throw std::runtime_error("Invalid snapshot: original ids are not a permutation");
+        seen[id] = 1;
+    }
+
+    nodes.view(nodeData, n);
+    edgeOffsets.view(offsetData, n + 1);
+    edgeTargets.view(targetData, m);
+    edgeWeights.view(weightData, m);
+    reverseOffsets.view(revOffsetData, n + 1);
+    reverseSources.view(revSourceData, m);
+    reverseEdges.view(revEdgeData, m);
+    originalIds.view(originalIdData, n);
+    edgeAttrs.view(attrData, m);
+    edgeWays.view(edgeWayData, m);
+    wayIds.view(wayIdData, wayCount);
+    mapping = std::move(region);
+    buildNodeIndexes();
+
+    std::vector<Node>().swap(pendingNodes);
+    std::vector<PendingEdge>().swap(pendingEdges);
+    std::vector<int64_t>().swap(pendingWayIds);
+    coordToIndex.clear();
+
+    std::cout << "Mapped graph snapshot with " << nodes.size() << " nodes\n";
+}
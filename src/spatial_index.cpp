@@ -0,0 +1,104 @@
+// spatial_index.cpp
+#include "spatial_index.hpp"
+#include "graph.hpp"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+void SpatialIndex::toUnitVector(double lat, double lon, double out[3])
+{
+    double rLat = lat * M_PI / 180.0;
+    double rLon = lon * M_PI / 180.0;
+    double cosLat = std::cos(rLat);
+    out[0] = cosLat * std::cos(rLon);
+    out[1] = cosLat * std::sin(rLon);
+    out[2] = std::sin(rLat);
+}
+
+void SpatialIndex::build(const Node *nodes, std::size_t count)
+{
+    points.resize(count);
+    for (size_t i = 0; i < count; ++i)
+    {
+        toUnitVector(nodes[i].lat, nodes[i].lon, points[i].xyz);
+        points[i].id = (int)i;
+        points[i].axis = 0;
+    }
+    buildRange(0, (int)points.size());
+}
+
+// Split on the axis with the widest extent, median point at the midpoint
+void SpatialIndex::buildRange(int lo, int hi)
+{
+    if (hi - lo <= 1)
+        return;
+
+    double minV[3], maxV[3];
+    for (int a = 0; a < 3; ++a)
+    {
+        minV[a] = std::numeric_limits<double>::infinity();
+        maxV[a] = -std::numeric_limits<double>::infinity();
+    }
+    for (int i = lo; i < hi; ++i)
+    {
+        for (int a = 0; a < 3; ++a)
+        {
+            minV[a] = std::min(minV[a], points[i].xyz[a]);
+            maxV[a] = std::max(maxV[a], points[i].xyz[a]);
+        }
+    }
+    int axis = 0;
+    for (int a = 1; a < 3; ++a)
+    {
+        if (maxV[a] - minV[a] > maxV[axis] - minV[axis])
+            axis = a;
+    }
+
+    int mid = lo + (hi - lo) / 2;
+    std::nth_element(points.begin() + lo, points.begin() + mid, points.begin() + hi,
+                     [axis](const KdPoint &a, const KdPoint &b)
+                     { return a.xyz[axis] < b.xyz[axis]; });
+    points[mid].axis = axis;
+
+    buildRange(lo, mid);
+    buildRange(mid + 1, hi);
+}
+
+void SpatialIndex::searchRange(int lo, int hi, const double q[3], const unsigned char *usable, double &bestDist2,
+                               int &bestId) const
+{
+    if (lo >= hi)
+        return;
+
+    int mid = lo + (hi - lo) / 2;
+    const KdPoint &p = points[mid];
+    double dx = q[0] - p.xyz[0];
+    double dy = q[1] - p.xyz[1];
+    double dz = q[2] - p.xyz[2];
+    double d2 = dx * dx + dy * dy + dz * dz;
+    if ((!usable || usable[p.id]) && (d2 < bestDist2 || (d2 == bestDist2 && p.id < bestId)))
+    {
+        bestDist2 = d2;
+        bestId = p.id;
+    }
+
+    double diff = q[p.axis] - p.xyz[p.axis];
+    bool leftFirst = diff < 0;
+    searchRange(leftFirst ? lo : mid + 1, leftFirst ? mid : hi, q, usable, bestDist2, bestId);
+    // <= keeps equidistant nodes with smaller ids reachable
+    if (diff * diff <= bestDist2)
+        searchRange(leftFirst ? mid + 1 : lo, leftFirst ? hi : mid, q, usable, bestDist2, bestId);
+}
+
+int SpatialIndex::nearest(double lat, double lon, const unsigned char *usable) const
+{
+    if (points.empty())
+        return -1;
+
+    double q[3];
+    toUnitVector(lat, lon, q);
+    double bestDist2 = std::numeric_limits<double>::infinity();
+    int bestId = -1;
+    searchRange(0, (int)points.size(), q, usable, bestDist2, bestId);
+    return bestId;
+}
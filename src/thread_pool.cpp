@@ -0,0 +1,126 @@
+// thread_pool.cpp
+#include "thread_pool.hpp"
+#include <atomic>
+#include <exception>
+#include <memory>
+
+#if defined(__EMSCRIPTEN__) && !defined(__EMSCRIPTEN_PTHREADS__)
+#define THREAD_POOL_INLINE_ONLY 1
+#endif
+
+ThreadPool::ThreadPool(unsigned threads)
+{
+#ifndef THREAD_POOL_INLINE_ONLY
+    for (unsigned i = 0; i < threads; ++i)
+        workers.emplace_back([this]()
+                             { workerLoop(); });
+#else
+    (void)threads;
+#endif
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    wake.notify_all();
+    for (auto &worker : workers)
+        worker.join();
+}
+
+void ThreadPool::workerLoop()
+{
+    for (;;)
+    {
+        std::function<void()> task;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            wake.wait(lock, [this]()
+                      { return stopping || !tasks.empty(); });
+            if (stopping && tasks.empty())
+                return;
+            task = std::move(tasks.front());
+            tasks.pop_front();
+        }
+        task();
+    }
+}
+
+void ThreadPool::parallelFor(std::size_t count, const std::function<void(std::size_t)> &fn,
+                             unsigned maxThreads)
+{
+    if (count == 0)
+        return;
+
+    unsigned helpers = size();
+    if (maxThreads > 0 && helpers > maxThreads - 1)
+        helpers = maxThreads - 1;
+    if (helpers > count - 1)
+        helpers = (unsigned)(count - 1);
+
+    if (helpers == 0)
+    {
+        for (std::size_t i = 0; i < count; ++i)
+            fn(i);
+        return;
+    }
+
+    // Shared with helper tasks, which may start after the loop is over
+    struct LoopState
+    {
+        std::atomic<std::size_t> next{0};
+        std::atomic<std::size_t> done{0};
+        std::mutex mutex;
+        std::condition_variable finished;
+        std::exception_ptr error;
+    };
+    auto state = std::make_shared<LoopState>();
+    const std::function<void(std::size_t)> *body = &fn;
+
+    auto run = [state, body, count]()
+    {
+        std::size_t i;
+        while ((i = state->next.fetch_add(1)) < count)
+        {
+            try
+            {
+                (*body)(i);
+            }
+            catch (...)
+            {
+                std::lock_guard<std::mutex> lock(state->mutex);
+                if (!state->error)
+                    state->error = std::current_exception();
+            }
+            if (state->done.fetch_add(1) + 1 == count)
+            {
+                std::lock_guard<std::mutex> lock(state->mutex);
+                state->finished.notify_all();
+            }
+        }
+    };
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        for (unsigned h = 0; h < helpers; ++h)
+            tasks.emplace_back(run);
+    }
+    wake.notify_all();
+
+    run();
+
+    std::unique_lock<std::mutex> lock(state->mutex);
+    state->finished.wait(lock, [&]()
+                         { return state->done.load() == count; });
+    if (state->error)
+        std::rethrow_exception(state->error);
+}
+
+ThreadPool &ThreadPool::shared()
+{
+    unsigned hw = std::thread::hardware_concurrency();
+    static ThreadPool pool(hw > 1 ? hw - 1 : 0);
+    return pool;
+}